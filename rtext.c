@@ -1,22 +1,182 @@
+// pthread_rwlock_t 在嚴格 C99 模式 (-std=c99) 下需要 POSIX 2001 以上的宣告
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "rtext.h"
-#include "stb_truetype.h"
+#include "rlgl.h"
 #include <stdlib.h>
+
+// stb_truetype 的暫存配置 (輪廓頂點、邊緣、掃描線與點陣) 改從點陣化暫存區切出，每個字形結束後整個重置
+#if !defined(STBTT_malloc)
+    static void* RasterArenaAlloc(size_t size);
+    static void RasterArenaFree(void* ptr);
+    #define STBTT_malloc(x, u) ((void)(u), RasterArenaAlloc(x))
+    #define STBTT_free(x, u) ((void)(u), RasterArenaFree(x))
+#endif
+#include "stb_truetype.h"
 #include <string.h>
+#include <math.h>
 #include <stdio.h> // for strcasecmp/strncasecmp (non-standard but common)
+#if !defined(_WIN32)
+    #include <strings.h> // strncasecmp (定義 _POSIX_C_SOURCE 後 string.h 不再宣告它)
+#endif
+
+// 背景點陣化執行緒 (POSIX threads；MSVC 或定義 ADVTEXT_NO_THREADS 時改為同步點陣化)
+#if !defined(ADVTEXT_NO_THREADS) && !defined(_MSC_VER)
+    #define ADVTEXT_THREADS
+    #include <pthread.h>
+#endif
+
+// 圖集上傳的 Alpha -> RGBA 展開使用 SSE2 或 NEON (定義 ADVTEXT_NO_SIMD 時改為逐位元組)
+#if !defined(ADVTEXT_NO_SIMD)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define ADVTEXT_SSE2
+        #include <emmintrin.h>
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define ADVTEXT_NEON
+        #include <arm_neon.h>
+    #endif
+#endif
+
+// 執行緒區域變數 (每個執行緒各自記錄目前作用中的上下文)
+#if defined(_MSC_VER)
+    #define ADVTEXT_THREAD_LOCAL __declspec(thread)
+#else
+    #define ADVTEXT_THREAD_LOCAL __thread
+#endif
+
+// 執行統計與效能分析回呼 (GetAdvTextStats / SetAdvTextProfilerHooks)；未定義時計數與計時全部編譯掉
+// #define ADVTEXT_ENABLE_STATS
+#if defined(ADVTEXT_ENABLE_STATS)
+    #include <time.h>
+#endif
+
+// 唯讀檔案映射 (POSIX mmap；Windows 或定義 ADVTEXT_NO_MMAP 時改用 LoadFileData，windows.h 與 raylib.h 名稱衝突)
+#if !defined(_WIN32) && !defined(ADVTEXT_NO_MMAP)
+    #define ADVTEXT_MMAP
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 
 // -------------------------------------------------------------------------
 // 參數設定 (可根據需求調整)
 // -------------------------------------------------------------------------
 
-// 最大快取字形數 (針對中文環境，建議設為 4096 或更高)
-#define MAX_GLYPHS 4096
+// 最大快取字形數 (針對中文環境，建議設為 4096 或更高；8192 可容納常用 CJK 工作集)
+#define MAX_GLYPHS 8192
+
+// 字形索引 (兩層直接對應表)：字形鍵的高 11 位 (strike、變體、描邊半徑) 選 face，碼點高位選頁，頁內 256 格直接存插槽
+#define GLYPH_FACE_COUNT (1 << 11)
+#define GLYPH_DIR_SIZE (0x110000 >> 8)  // 碼點上限 U+10FFFF 的高位數
+#define GLYPH_INDEX_PAGE_SIZE 256
 
 // 紋理圖集大小 (2048x2048 可容納更多字，減少 Flush 頻率)
 #define ATLAS_SIZE 2048
 
-// 最大行數與標籤長度限制
-#define MAX_TAG_LEN 32
+// 最大圖集頁數 (需要時才建立新頁，每頁一張 ATLAS_SIZE 紋理)
+#define MAX_ATLAS_PAGES 4
+
+// 字形之間的間距 (避免雙線性取樣時採到鄰居)
+#define ATLAS_PADDING 2
+
+// 圖集閒置區域依高度分桶 (每桶 4 像素)，配置時只往上找幾個桶，避免小字佔用過大的區域
+#define FREE_CELL_BUCKETS 64
+#define FREE_CELL_BUCKET(h) (((h) >> 2) < FREE_CELL_BUCKETS ? ((h) >> 2) : FREE_CELL_BUCKETS - 1)
+#define FREE_CELL_SEARCH 3
+
+// 回收時從 LRU 尾端往前最多看幾個冷字形，找圖集區域容得下新字形者 (找不到才清空圖集頁)
+#define EVICT_SEARCH 8
+
+// 繪製前的準備途中快取被整個清空時，最多重新確認幾次 (清空後仍放不下整段排版才會用完)
+#define PREPARE_FLUSH_RETRIES 2
+
+// 背景點陣化執行緒數與佇列容量 (PrefetchAdvText 使用)
+#define RASTER_WORKER_COUNT 2
+#define MAX_RASTER_JOBS 1024
+
+// 點陣化暫存區的對齊與擴大粒度 (不夠用時依上一個字形實際用量擴大，之後不再配置)
+#define RASTER_ARENA_ALIGN 16
+#define RASTER_ARENA_GRANULARITY (64 * 1024)
+
+// 烘焙快取檔格式 (BakeAdvTextCache / InitAdvTextFromCache)
+#define CACHE_FILE_MAGIC "RTXC"
+#define CACHE_FILE_VERSION 4
+
+// SDF 模式：距離場以固定字號產生，任意字號由同一份圖集縮放繪製
+// 邊緣外 SDF_PADDING 像素的距離值遞減到 0 (描邊寬度與陰影偏移受此限制)
+#define SDF_BASE_SIZE 48
+#define SDF_PADDING 8
+#define SDF_ONEDGE 128
+#define SDF_PIXEL_DIST_SCALE ((float)SDF_ONEDGE / SDF_PADDING)
+
+// 描邊字形的最大擴張半徑 (像素，存在字形鍵的 4 個位元中)
+#define MAX_OUTLINE_RADIUS 15
+
+// 最多可註冊的字型數 (主字型 + 備援/粗體/標題字型)
+#define MAX_FONTS 8
+#define MAX_FONT_NAME 32
+
+// 初始化旗標中主字型的集合索引 (ADVTEXT_FLAG_FACE)
+#define FLAG_FACE_INDEX(flags) ((int)(((flags) >> 8) & 0xFF))
+
+// 碼點 -> 字型的解析結果快取大小 (備援搜尋每個碼點只做一次)
+#define FONT_MEMO_SIZE 4096
+
+// 字距對快取大小 (同一字型相鄰兩字的 kern/GPOS 調整，每對只向 stbtt 查一次)
+#define KERN_MEMO_SIZE 4096
+
+// 最多同時快取的 (字型, 字號) 組合數 (存在字形鍵的 5 個位元中，滿了回收最久未用的字號)
+#define MAX_STRIKES 32
+
+// 字形鍵：低 21 位為碼點，其上 2 位為變體，再上 4 位為描邊半徑，最高 5 位為 (字型, 字號) 組合
+// (同一個字的點陣、SDF、各種粗細的描邊字形與不同字型、字號分開快取)
+#define GLYPH_VARIANT_BITMAP 0
+#define GLYPH_VARIANT_SDF 1
+#define GLYPH_VARIANT_OUTLINE 2
+#define MAKE_GLYPH_KEY(strike, cp, variant) ((unsigned int)(cp) | ((unsigned int)(variant) << 21) | ((unsigned int)(strike) << 27))
+#define MAKE_OUTLINE_KEY(strike, cp, radius) (MAKE_GLYPH_KEY(strike, cp, GLYPH_VARIANT_OUTLINE) | ((unsigned int)(radius) << 23))
+#define GLYPH_KEY_CODEPOINT(key) ((int)((key) & 0x1FFFFF))
+#define GLYPH_KEY_VARIANT(key) ((int)(((key) >> 21) & 0x3))
+#define GLYPH_KEY_RADIUS(key) ((int)(((key) >> 23) & 0xF))
+#define GLYPH_KEY_STRIKE(key) ((int)(((key) >> 27) & 0x1F))
+
+// 不會被查到的字形鍵 (變體 3 不存在)，字號被回收時標記其字形
+#define RETIRED_GLYPH_KEY 0xFFFFFFFFu
+
+// 每個 rlBegin(RL_QUADS) 批次最多幾個四邊形 (需小於 rlgl 批次緩衝區，ES2 預設 2048)
+#define DRAW_BATCH_QUADS 1024
+
+// 每次上傳最多幾列 (限制 RGBA 暫存緩衝區大小：ATLAS_SIZE * 列數 * 4 bytes)
+#define ATLAS_UPLOAD_ROWS 128
+
+// 標籤最大長度 (含中括號；超過時視為一般文字)
+#define MAX_TAG_LEN 64
+
+// 巢狀標籤的樣式堆疊深度 (超過時覆蓋最上層)
+#define STYLE_STACK_DEPTH 16
+
+// 靜態文字區塊快取 (DrawRichTextCached)：整個樣式化區塊畫進渲染紋理，之後每幀只畫一個四邊形
+#define MAX_TEXT_BLOCKS 64
+#define TEXT_BLOCK_BUDGET (16 * 1024 * 1024)  // 預設的紋理記憶體上限 (位元組)
+#define TEXT_BLOCK_GRANULARITY 64             // 紋理尺寸取整的單位 (大小相近的區塊可重複使用同一張紋理)
+
+// 量測備忘 (MeasureRichText)：保留最近量測過的排版結果，之後的點擊測試與繪製直接沿用
+#define MAX_MEASURE_MEMOS 16
+
+// 串流文字 (聊天、戰鬥紀錄) 未指定上限時保留的行數與每行預估字數 (決定字形環的大小)
+#define STREAM_DEFAULT_LINES 1000
+#define STREAM_GLYPHS_PER_LINE 48
+
+// 標籤與顏色名稱字典的完美雜湊：FNV-1a (不分大小寫) 乘上種子後取高位，直接對應表格位置
+// 種子是離線搜尋讓所有名稱互不碰撞的值；增加名稱後若初始化時回報碰撞，需重新搜尋
+#define TAG_HASH_BITS 3
+#define TAG_HASH_SEED 13u
+#define COLOR_HASH_BITS 6
+#define COLOR_HASH_SEED 1373u
 
 // -------------------------------------------------------------------------
 // 內部結構與全局變數
@@ -24,28 +184,491 @@
 
 // 字形結構（儲存每個字元的紋理資訊）
 typedef struct {
-    int codepoint;          // Unicode碼點
+    unsigned int key;       // 字形鍵 (碼點 + 變體)
     Rectangle srcRec;       // 在圖集中的矩形區域
+    int page;               // 所在的圖集頁
     int bearingX, bearingY; // 字形偏移量
-    int advance;            // 文字前進寬度
+    float advance;          // 文字前進寬度 (保留小數，排版時以浮點累加)
+    int glyphIndex;         // stbtt 字形索引 (cmap 只在建立字形時查一次；字距查詢使用)
+    Rectangle cell;         // 佔用的圖集區域 (回收再利用時可能大於 srcRec)
+    unsigned int lastUsed;  // 最後使用的幀編號 (LRU 回收依據)
+    int lruPrev, lruNext;   // LRU 鏈的前後插槽 (-1 為兩端；只有使用中的插槽在鏈上)
+    unsigned int serial;    // 插槽內容的版本 (回收、清空或寫入點陣時遞增；排版記下取得時的值，繪製前比對)
+    bool ready;             // 點陣已寫入圖集 (預載中的字形只有度量資訊)
     bool active;            // 此插槽是否被佔用
 } AdvGlyph;
 
-// 全局上下文
-static struct {
-    unsigned char* fontData;      // 原始字型檔案資料
+// 富文本片段：樣式相同的一段文字 (標籤已解析並移除，排版、預載與打字機共用)
+typedef struct {
+    int start, end;               // 文字區段 [start, end) (原文的位元組位置；只有結尾停頓時為空區段)
+    Color color;                  // 字色 (已套用顏色標籤堆疊)
+    int font;                     // 指定的字型 (已套用字型標籤堆疊)
+    float pause;                  // 區段開始前的停頓秒數 ([pause=] 標籤)
+} TextRun;
+
+typedef struct {
+    TextRun* runs;
+    int count, capacity;
+} TextRunList;
+
+// 排版後的單一字形 (位置相對於繪製原點)
+typedef struct {
+    unsigned int key;       // 字形鍵 (快取清空後用來重新取得字形)
+    int slot;               // 快取插槽 (繪製時標記使用，避免被回收)
+    unsigned int serial;    // 取得時插槽的版本 (與插槽目前的版本不同才重新取得)
+    Rectangle srcRec;       // 在圖集中的矩形區域
+    int page;               // 所在的圖集頁 (-1 表示字形尚在背景點陣化，暫不繪製)
+    Vector2 offset;         // 繪製位置 (已含 bearing 與對齊偏移)
+    Color color;            // 字色 (已套用顏色標籤)
+    int textOffset;         // 在原文中的位元組位置
+    int outlineSlot;        // 描邊字形的快取插槽 (-1 表示不描邊)
+    unsigned int outlineSerial; // 取得時描邊字形插槽的版本
+    Rectangle outlineRec;   // 描邊字形在圖集中的矩形區域 (繪製位置為 offset 往左上退 outlineRadius)
+    int outlinePage;        // 描邊字形所在的圖集頁 (-1 表示尚未就緒或不描邊)
+} AdvLayoutGlyph;
+
+// 排版後的一行
+typedef struct {
+    float y;                // 行頂端位置 (相對於原點)
+    float width;            // 行寬
+    int firstGlyph;         // 本行第一個字形的索引
+    int glyphCount;         // 本行字形數
+    Rectangle bgRec;        // 行背景矩形 (相對於原點)
+    int textOffset;         // 行首在原文中的位元組位置
+    int run;                // 行首所在的片段 (從這裡接續排版即帶有當時的顏色與字型)
+    int firstItem;          // 本行第一個斷行項目的索引 (點擊測試用)
+} AdvLayoutLine;
+
+// 斷行項目：排版時每個字形與換行字元各一筆 (依原文順序)，重新換行時不需再解析文字與查詢字形
+// 位置以 1/LAYOUT_UNITS_PER_PIXEL 像素的整數累加：任一段的寬度都是兩個前綴和相減，
+// 從長文件中途接續排版的結果與整份排版完全一致
+typedef struct {
+    long long penX;         // 不換行時的筆位置 (前綴和，已含與前一字的字距)
+    int advance;            // 前進寬度
+    Vector2 bearing;        // 字形偏移 (已縮放)
+    int run, textOffset;    // 所在片段與在原文中的位元組位置 (行首記錄用)
+    int prevBreak;          // 本項之前 (含本項) 最後一個可在其前斷行的項目 (-1 表示本段落中沒有)
+    int nextNewline;        // 本項之後 (含本項) 第一個換行字元 (沒有時為項目數)
+    unsigned char flags;    // LAYOUT_ITEM_*
+} AdvLayoutItem;
+
+#define LAYOUT_UNITS_PER_PIXEL 1024
+#define TO_LAYOUT_UNITS(x) ((long long)floorf((x) * LAYOUT_UNITS_PER_PIXEL + 0.5f))
+#define LAYOUT_ITEM_BREAK      0x01 // 可在本項之前斷行
+#define LAYOUT_ITEM_SPACE      0x02 // 空白 (自動換行時懸掛在行尾，不計入行寬)
+#define LAYOUT_ITEM_NEWLINE    0x04 // 換行字元 (不對應字形)
+
+// 排版用到的 (字型, 字號) 組合：字形鍵只存 strike 編號，編號被回收給其他字號時以版本察覺並重新取得
+typedef struct {
+    int strike[MAX_FONTS];        // 每個字型使用的 strike (-1 為沒用到)
+    unsigned int epoch[MAX_FONTS]; // 取得時 strike 的版本 (AdvStrike.epoch)
+    int size;                     // 像素字號 (0 表示沒有記錄)
+} StrikeBinding;
+
+// 保留模式排版結果 (解析與排版一次，之後每幀只需繪製)
+struct AdvTextLayout {
+    AdvTextStyle style;           // 排版時使用的樣式 (已套用預設值)
+    AdvLayoutGlyph* glyphs;       // 依顯示順序排列的字形
+    int glyphCount, glyphCapacity;
+    AdvLayoutLine* lines;         // 行資訊
+    int lineCount, lineCapacity;
+    float width, height;          // 整體尺寸 (最寬行寬、總行高)
+    Rectangle globalBgRec;        // 全域背景矩形 (相對於原點)
+    unsigned int pageMask;        // 用到的圖集頁 (繪製時依頁分組)
+    float glyphScale;             // 字形繪製縮放 (SDF 模式為 fontSize / SDF_BASE_SIZE，點陣模式為 1)
+    int outlineRadius;            // 點陣模式的描邊半徑 (使用預先擴張的描邊字形，0 為不描邊)
+    unsigned int strikeMask;      // 用到的 (字型, 字號) 組合 (繪製時釘住，避免被回收)
+    StrikeBinding strikes;        // 每個字型對應的 strike 與其版本 (繪製前確認沒有被回收)
+    TextRunList runs;             // 標籤解析結果 (每個排版各自一份，背景執行緒排版互不干擾)
+    AdvLayoutItem* items;         // 斷行項目 (以新寬度重新換行時使用)
+    int itemCount, itemCapacity;
+    bool itemsUnordered;          // 段落中有項目的筆位置或結尾小於前一項 (負字距、零寬字形)：分行與點擊測試改用線性搜尋
+    float ascent, lineHeight;     // 第一行基線位置與行高 (重新換行時使用)
+    AdvTextContext* ctx;          // 建立此排版的上下文 (繪製與重新取得字形時使用)
+};
+
+// 只排版原文的一段 (長文件的可見範圍)：從片段 run 的位元組位置 start 開始，到 end 為止，第一行的頂端為 y
+typedef struct {
+    int run;
+    int start, end;
+    float y;
+} LayoutRange;
+
+// 長文件的行索引 (建立時排版一次取得，之後從任一行接續排版)
+typedef struct {
+    int textOffset;         // 行首位元組位置
+    int run;                // 行首所在的片段 (帶有顏色與字型堆疊的結果)
+    float y;                // 行頂端位置
+} AdvDocumentLine;
+
+// 長文件：只保留行索引，每幀只排版與繪製和裁切矩形相交的行
+struct AdvTextDocument {
+    char* text;                   // 原文副本 (重新排版可見範圍時使用)
+    AdvDocumentLine* lines;       // 行索引 (多一筆結尾哨兵，textOffset 為原文長度)
+    int lineCount;
+    float width, height;          // 整份文件的尺寸
+    float lineHeight;
+    AdvTextLayout window;         // 可見範圍的排版結果 (片段為整份原文的解析結果)
+    int firstLine, endLine;       // window 涵蓋的行 [firstLine, endLine)
+};
+
+// 串流中保留的一行 (字形存在字形環中，y 相對於行頂)
+typedef struct {
+    int firstGlyph;               // 在字形環中的起點
+    int glyphCount;
+    float width;
+    Rectangle bgRec;              // 行背景矩形 (y 相對於行頂)
+} AdvStreamLine;
+
+// 只追加的串流文字：新訊息只排版自己的行，行與字形都存在固定大小的環中，舊行被擠出
+struct AdvTextStream {
+    AdvTextContext* ctx;          // 建立此串流的上下文
+    AdvTextLayout scratch;        // 新訊息的排版暫存 (容量只隨最長的訊息成長)
+    AdvStreamLine* lines;         // 行環 (oldest 為最舊的一行)
+    int oldest, lineCount, maxLines;
+    AdvLayoutGlyph* glyphs;       // 字形環 (與行環同步擠出)
+    int glyphStart, glyphCount, glyphCapacity;
+    float lineHeight;
+    unsigned int strikeMask;      // 保留的行用到的字號 (繪製時釘住)
+    StrikeBinding strikes;        // 保留的行用到的 strike 與其版本 (被回收時改寫環中的字形鍵)
+    unsigned int serial;          // 內容變更次數 (追加或清除後重建可見範圍)
+    AdvTextLayout window;         // 可見範圍 (y 相對於最新一行的底端，往上為負)
+    int windowFirst, windowEnd;   // window 涵蓋的行 (由最新一行往回數) [windowFirst, windowEnd)
+    unsigned int windowSerial;
+};
+
+// 打字機的一個顯示步驟 (每個排版字形一筆，建立時算好，每幀只往前推進)
+typedef struct {
+    float revealTime;       // 從開始到此字出現的時間 (秒，已含停頓)
+    int textOffset;         // 在原文中的位元組位置
+    int line;               // 所在行
+    int codepoint;          // 碼點 (回呼使用)
+} AdvRevealStep;
+
+// 打字機物件：整段文字只排版一次，顯示進度只是時間表上的索引
+struct AdvTypewriter {
+    AdvTextLayout layout;         // 排版結果
+    AdvRevealStep* steps;         // 每個字形的顯示時間表 (數量等於 layout.glyphCount)
+    float endTime;                // 全部顯示完 (含結尾停頓) 的時間
+    float elapsed;                // 累積時間
+    int visible;                  // 已顯示字數
+    AdvTypewriterConfig config;   // 速度、停頓與回呼
+    bool isFinished;
+};
+
+// 字形索引頁：同一個 face 中碼點高位相同的 256 個字
+typedef struct {
+    int slots[GLYPH_INDEX_PAGE_SIZE]; // 碼點低 8 位 -> 快取插槽 (-1 為空；閒置頁的 slots[0] 串成閒置鏈)
+    int used;                         // 使用中的格數 (歸零時整頁回收)
+} GlyphIndexPage;
+
+// 一個 face (同一 strike、變體與描邊半徑) 的頁目錄
+typedef struct {
+    unsigned short* dir;          // 碼點高位 -> 頁編號 + 1 (0 為沒有頁；第一次插入時配置)
+    int pageCount;                // 使用中的頁數 (歸零時釋放目錄)
+} GlyphFace;
+
+// 天際線節點：[x, x + width) 區間目前已用到的高度為 y
+typedef struct {
+    int x, y, width;
+} SkylineNode;
+
+// 圖集頁 (天際線矩形打包，比單一游標換行更省空間)
+typedef struct {
+    Texture2D texture;                // 紋理 (GPU)
+    SkylineNode skyline[ATLAS_SIZE];  // 天際線 (由左到右覆蓋整個寬度)
+    int nodeCount;
+    int usedArea;                     // 已配置的面積 (含間距，用於計算填充率)
+    unsigned char* pixels;            // CPU 端鏡像 (單通道 Alpha，新字形先寫這裡)
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1; // 尚未上傳的區域 (合併成一個矩形，x0 >= x1 表示乾淨)
+} AtlasPage;
+
+// 圖集閒置區域：字形被回收而新字形沒有沿用的區域 (天際線無法歸還，改由這裡重複使用)
+typedef struct {
+    Rectangle cell;                   // 區域 (與 AdvGlyph.cell 相同，不含間距)
+    int page;
+    int next;                         // 同一桶的下一個 (-1 為結尾；未使用的節點串成閒置鏈)
+} AtlasFreeCell;
+
+// 點陣化暫存區 (bump allocator)：點陣化一個字形的所有暫存配置都從這裡切出，字形結束後整個重置
+typedef struct {
+    unsigned char* base;    // MemAlloc 配置的區塊
+    size_t size;            // 區塊大小
+    size_t used;            // 本字形已切出的量
+    size_t demand;          // 本字形要求的總量 (含放不下而改用 MemAlloc 的部分，重置時依此擴大)
+    void* overflow;         // 放不下而改用 MemAlloc 的區塊 (鏈結，重置時釋放)
+} RasterArena;
+
+// 暫存區配置的前置資訊 (佔 RASTER_ARENA_ALIGN 個位元組)
+typedef struct {
+    void* next;             // overflow 鏈結
+    int kind;               // 0: 暫存區內，1: 暫存區的 overflow，2: 沒有暫存區時的 MemAlloc (個別釋放)
+} RasterArenaHeader;
+
+// 背景點陣化工作 (工作執行緒只讀取字型資料，圖集只由主執行緒寫入)
+typedef struct {
+    unsigned int key;       // 要點陣化的字形鍵
+    int slot;               // 預先配置好的快取插槽
+    unsigned int serial;    // 排入時插槽的版本 (插槽被回收再配置時不同，避免同一個字的新字形收到舊結果)
+    int font;               // 字型
+    int glyphIndex;         // stbtt 字形索引
+    float scale;            // 縮放比例 (排入時取得，字號被回收也不受影響)
+    unsigned char* bitmap;  // 結果 (從工作執行緒的暫存區複製出來，主執行緒寫入圖集後釋放)
+    int w, h;               // 結果尺寸
+#if defined(ADVTEXT_ENABLE_STATS)
+    unsigned long long ns;  // 點陣化花費的時間 (主執行緒寫入圖集時計入統計)
+#endif
+} RasterJob;
+
+// 背景點陣化執行緒池
+typedef struct {
+#if defined(ADVTEXT_THREADS)
+    pthread_t threads[RASTER_WORKER_COUNT];
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif
+    RasterJob queue[MAX_RASTER_JOBS];   // 待處理 (環狀佇列)
+    int queueHead, queueCount;
+    RasterJob done[MAX_RASTER_JOBS];    // 已完成，等主執行緒寫入圖集
+    int doneHead, doneCount;
+    int inFlight;                       // 已排入但尚未寫入圖集的工作數
+    bool running;                       // 執行緒是否已啟動
+    bool quit;                          // 通知執行緒結束
+} RasterWorkers;
+
+// 烘焙快取檔：檔頭 -> 字形紀錄 -> 每頁已用列數 -> 每頁 Alpha 像素 (只存已用的列)
+typedef struct {
+    char magic[4];              // "RTXC"
+    int version;                // CACHE_FILE_VERSION
+    int fontSize;               // 烘焙時的字號
+    int atlasSize;              // 必須等於 ATLAS_SIZE
+    int pageCount;              // 圖集頁數
+    int glyphCount;             // 字形數
+    int ascent, descent, lineGap; // 已縮放的字型度量
+    int faceIndex;              // 烘焙時使用的 TrueType 集合索引 (載入時以同一個 face 提供字距與未烘焙的字)
+} CacheFileHeader;
+
+typedef struct {
+    int codepoint;              // Unicode碼點
+    short x, y, w, h;           // 在圖集中的區域
+    short bearingX, bearingY;   // 字形偏移量
+    short page;                 // 所在的圖集頁
+    int glyphIndex;             // stbtt 字形索引 (同時提供字型檔時用於字距)
+    float advance;              // 文字前進寬度
+} CacheFileGlyph;
+
+// 映射到記憶體的唯讀檔案
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    bool mapped;                // true: mmap，false: LoadFileData
+} MappedFile;
+
+// SDF 合成著色器 (第一次使用 SDF 模式時載入)
+typedef struct {
+    Shader shader;
+    int outlineColorLoc, outlineWidthLoc;
+    int shadowColorLoc, shadowOffsetLoc;
+    int smoothingLoc;
+    bool loaded;
+} SDFShader;
+
+// 已註冊的字型 (註冊後唯讀，背景執行緒可同時點陣化)
+typedef struct {
+    MappedFile file;              // 映射的字型檔 (從快取檔初始化且未提供字型時 data 為 NULL)
     stbtt_fontinfo info;          // stb_truetype 字型資訊
+    char name[MAX_FONT_NAME];     // [font=名稱] 標籤使用的名稱
+    int ascent, descent, lineGap; // 未縮放的字型度量
+    bool fallback;                // 是否加入備援鏈 (其他字型缺字時依註冊順序嘗試)
+    bool hasKerning;              // 字型有 kern 或 GPOS 表 (沒有時排版完全略過字距查詢)
+} AdvFont;
+
+// 字型在某個字號下的縮放與度量 (字形鍵中的 strike；SDF 字形固定使用 SDF_BASE_SIZE)
+typedef struct {
+    int font;                     // 字型
+    int size;                     // 像素字號
+    float scale;                  // stbtt 縮放比例 (沒有字型資料時為 0)
+    int ascent, descent, lineGap; // 已縮放的度量 (切換字號只需查表)
+    unsigned int lastUsed;        // 最後使用的幀編號 (表滿時回收最久未用者)
+    unsigned int epoch;           // 版本 (每次指派給一個 (字型, 字號) 時取得新值，排版以此察覺編號被回收)
+    bool active;
+} AdvStrike;
+
+// 碼點 -> 字型解析結果 (開放定址，key 為 0 表示空位；碼點 0 不會被查詢)
+typedef struct {
+    unsigned int key;             // MAKE_GLYPH_KEY(指定的字型, 碼點, 0) (字型編號放在 strike 的位置)
+    int font;                     // 實際使用的字型
+} FontMemoEntry;
+
+// 字距對快取 (開放定址，pair 為 0 表示空位；字形索引 0 是缺字框，不會查詢字距)
+typedef struct {
+    unsigned int pair;            // (左字形索引 << 16) | 右字形索引
+    short font;                   // 字型
+    short kern;                   // 未縮放的字距調整 (字型單位)
+} KernMemoEntry;
+
+// 富文本標籤種類
+typedef enum {
+    RICH_TAG_NONE = 0,
+    RICH_TAG_COLOR,               // [color=名稱 或 #RRGGBB[AA]]
+    RICH_TAG_COLOR_END,           // [/color]
+    RICH_TAG_FONT,                // [font=名稱]
+    RICH_TAG_FONT_END,            // [/font]
+    RICH_TAG_PAUSE                // [pause=秒]
+} RichTagKind;
+
+// 完美雜湊字典的一格 (name 為 NULL 表示空格)
+typedef struct {
+    const char* name;
+    int len;
+    RichTagKind kind;             // 標籤字典使用
+    Color color;                  // 顏色字典使用
+} RichDictEntry;
+
+// 靜態文字區塊 (active 為 false 但仍有紋理時，紋理留在池中給同尺寸的區塊重複使用)
+typedef struct {
+    unsigned long long key;       // 原文與樣式的雜湊
+    int textLength;               // 原文長度 (與雜湊一起比對)
+    RenderTexture2D target;       // 紋理 (尺寸以 TEXT_BLOCK_GRANULARITY 取整)
+    Rectangle bounds;             // 區塊範圍 (相對於繪製位置，寬高為整數像素)
+    unsigned int lastUsed;        // 最後使用的幀編號 (LRU 回收依據)
+    bool active;
+} TextBlock;
+
+// 量測備忘：同一段文字與樣式的排版結果 (量測、點擊測試與繪製共用；未使用時保留陣列容量)
+typedef struct {
+    unsigned long long key;       // 原文與樣式的雜湊 (與 TextBlock 相同)
+    int textLength;               // 原文長度 (與雜湊一起比對)
+    const char* text;             // 最後一次量測的原文指標 (只用來決定繪製時要不要計算雜湊，不會讀取)
+    AdvTextLayout layout;         // 排版結果
+    float* lineWidths;            // 每行寬度 (MeasureRichText 回傳)
+    int lineWidthCapacity;
+    unsigned int lastUsed;        // 最後使用的幀編號 (LRU 回收依據)
+    bool active;
+} MeasureMemo;
+
+// 文字系統上下文 (字型、字形快取、圖集與暫存資料；各上下文互相獨立)
+// 多執行緒排版：cacheLock 保護快取與各種查詢表，BuildAdvTextLayoutCtx 以讀鎖查詢，缺字時才換成寫鎖
+struct AdvTextContext {
+    AdvFont fonts[MAX_FONTS];     // 字型 (0 為主字型)
+    int fontCount;
+    FontMemoEntry fontMemo[FONT_MEMO_SIZE]; // 碼點 -> 字型解析快取
+    int fontMemoCount;
+    KernMemoEntry kernMemo[KERN_MEMO_SIZE]; // 字距對快取
+    int kernMemoCount;
+    AdvStrike strikes[MAX_STRIKES]; // (字型, 字號) 組合 (0 為主字型的初始字號，不會被回收)
+    unsigned int strikeEpoch;     // 最後發出的 strike 版本 (重新初始化也不歸零)
+    RichDictEntry tagDict[1 << TAG_HASH_BITS];     // 標籤名稱 -> 種類
+    RichDictEntry colorDict[1 << COLOR_HASH_BITS]; // 顏色名稱 -> 顏色
+    bool dictReady;               // 字典是否已建立 (只建立一次，卸載後保留)
+    TextRunList runs;             // 標籤解析的暫存片段 (重複使用容量)
     
     AdvGlyph cache[MAX_GLYPHS];   // 字形資料陣列
-    int hashLookup[MAX_GLYPHS];   // [NEW] 雜湊表 (Codepoint -> Cache Index)
+    int freeSlots[MAX_GLYPHS];    // 閒置插槽堆疊 (配置與釋放都是 O(1))
+    int freeSlotCount;
+    int lruHead, lruTail;         // LRU 鏈：開頭最近使用，尾端最久未用 (依 lastUsed 遞減排列，-1 為空)
+    GlyphFace faces[GLYPH_FACE_COUNT]; // 字形索引 (Glyph Key -> Cache Index)
+    GlyphIndexPage* indexPages;   // 所有 face 共用的索引頁 (以編號引用，擴充時可搬移)
+    int indexPageCount, indexPageCapacity;
+    int freeIndexPage;            // 閒置索引頁鏈的開頭 (-1 為沒有)
     
-    Texture2D atlas;              // 紋理圖集 (GPU)
-    int atlasX, atlasY, rowHeight;// 圖集游標位置與目前行高
+    AtlasPage pages[MAX_ATLAS_PAGES]; // 紋理圖集頁 (需要時才建立)
+    int pageCount;                // 已建立的頁數
+    AtlasFreeCell freeCells[MAX_GLYPHS]; // 閒置區域節點 (每個區域原本屬於一個字形，數量不超過插槽數)
+    int freeCellBuckets[FREE_CELL_BUCKETS]; // 依高度分桶的閒置區域鏈 (-1 為空)
+    int freeCellPool;             // 未使用節點鏈的開頭 (-1 為沒有)
+    unsigned char* uploadBuffer;  // 上傳時 Alpha -> RGBA 展開用的暫存緩衝區 (重複使用)
+    RasterArena rasterArena;      // 主執行緒點陣化的暫存區 (重複使用)
+    RasterWorkers workers;        // 背景點陣化 (第一次 PrefetchAdvText 時啟動)
     
-    float scale;                  // 字型縮放比例
-    int ascent, descent, lineGap; // 字型度量資訊
+    unsigned int frame;           // 目前幀編號 (BeginAdvTextFrame 遞增，本幀用過的字形不會被回收)
+    bool framesTracked;           // 曾呼叫 BeginAdvTextFrame (之後快取滿時不再清空有本幀字形的圖集頁)
+    unsigned int flushCount;      // FlushCache 次數 (不受 ADVTEXT_ENABLE_STATS 影響；繪製前的準備據此判斷是否要重來)
+    AdvTextLayout scratch;        // DrawRichTextStyled 重複使用的暫存排版
+    AdvTextDrawList drawList;     // 繪製時重複使用的四邊形清單
+    unsigned int flags;           // 初始化旗標 (ADVTEXT_FLAG_*)
+
+    int fontSize;                 // 初始化時的字號 (樣式 fontSize 為 0 時使用)
+    SDFShader sdf;                // SDF 合成著色器
+#if defined(ADVTEXT_THREADS)
+    pthread_rwlock_t cacheLock;   // 快取讀寫鎖 (渲染執行緒的函數取寫鎖，背景排版先取讀鎖)
+#endif
+    bool lockReady;               // cacheLock 是否已初始化
+    TextBlock blocks[MAX_TEXT_BLOCKS]; // 靜態文字區塊快取
+    int blockBytes;               // 區塊紋理佔用的位元組 (含池中的紋理)
+    int blockBudget;              // 區塊紋理的記憶體上限 (0 為 TEXT_BLOCK_BUDGET)
+    MeasureMemo memos[MAX_MEASURE_MEMOS]; // 量測備忘
+    int memoCount;                // 使用中的備忘數 (0 時繪製不需計算雜湊查詢)
+#if defined(ADVTEXT_ENABLE_STATS)
+    AdvTextCounters statFrame;    // 本幀累計中的計數
+    AdvTextCounters statLastFrame; // 上一個完整的幀 (BeginAdvTextFrame 時交換)
+    AdvTextCounters statTotal;    // 初始化以來的累計
+#endif
     bool loaded;                  // 模組是否已初始化
-} g_ctx = { 0 };
+};
+
+// 預設上下文 (InitAdvText、DrawRichTextStyled 等不帶上下文的函數使用)
+static AdvTextContext g_defaultCtx = { 0 };
+
+// 本執行緒目前作用中的上下文：公開函數進入時設定，內部函數一律透過 g_ctx 存取
+static ADVTEXT_THREAD_LOCAL AdvTextContext* g_current = &g_defaultCtx;
+#define g_ctx (*g_current)
+
+// 本執行緒正在使用的點陣化暫存區 (stb_truetype 的配置從這裡切出；NULL 時直接使用 MemAlloc)
+static ADVTEXT_THREAD_LOCAL RasterArena* g_rasterArena;
+
+// 統計計數：STAT_ADD 在持有寫鎖 (或單執行緒) 時使用；背景排版在讀鎖下累計到執行緒區域變數，結束時一次以原子操作加入
+#if defined(ADVTEXT_ENABLE_STATS)
+    #define STAT_ADD(field, n) do { g_ctx.statFrame.field += (n); g_ctx.statTotal.field += (n); } while (0)
+    #if defined(ADVTEXT_THREADS)
+        #define STAT_ADD_SHARED(field, n) do { __atomic_fetch_add(&g_ctx.statFrame.field, (n), __ATOMIC_RELAXED); \
+                                               __atomic_fetch_add(&g_ctx.statTotal.field, (n), __ATOMIC_RELAXED); } while (0)
+    #else
+        #define STAT_ADD_SHARED(field, n) STAT_ADD(field, n)
+    #endif
+    #define STAT_ZONE_BEGIN(var, name) unsigned long long var = BeginStatZone(name)
+    #define STAT_ZONE_END(var, name, field) STAT_ADD(field, EndStatZone(name, var))
+
+// 效能分析回呼 (所有上下文共用)
+static struct {
+    AdvTextZoneCallback begin, end;
+    void* userData;
+} g_profiler = { 0 };
+
+// 背景排版在讀鎖下的快取命中數 (排版結束時加入統計)
+static ADVTEXT_THREAD_LOCAL unsigned int g_sharedHits;
+
+static unsigned long long GetStatTime(void)
+{
+#if defined(_WIN32)
+    return (unsigned long long)clock() * (1000000000ull / CLOCKS_PER_SEC);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+// 區段開始：通知效能分析器並回傳開始時間
+static unsigned long long BeginStatZone(const char* name)
+{
+    if (g_profiler.begin) g_profiler.begin(name, g_profiler.userData);
+    return GetStatTime();
+}
+
+// 區段結束：回傳經過的奈秒數
+static unsigned long long EndStatZone(const char* name, unsigned long long start)
+{
+    unsigned long long ns = GetStatTime() - start;
+    if (g_profiler.end) g_profiler.end(name, g_profiler.userData);
+    return ns;
+}
+#else
+    #define STAT_ADD(field, n) ((void)0)
+    #define STAT_ADD_SHARED(field, n) ((void)0)
+    #define STAT_ZONE_BEGIN(var, name) ((void)0)
+    #define STAT_ZONE_END(var, name, field) ((void)0)
+#endif
 
 // -------------------------------------------------------------------------
 // 內部輔助函數 (Private)
@@ -60,471 +683,4182 @@ static int SafeStrNCaseCmp(const char* s1, const char* s2, size_t n) {
 #endif
 }
 
-// 解析顏色標籤 [color=xxx]
-static Color GetTagColor(const char* tag_start)
-{
-    // tag_start 指向 "color=" 後面的內容
-    // 為了安全與效能，我們只比對有限長度
-    if (SafeStrNCaseCmp(tag_start, "red", 3) == 0) return RED;
-    if (SafeStrNCaseCmp(tag_start, "green", 5) == 0) return GREEN;
-    if (SafeStrNCaseCmp(tag_start, "blue", 4) == 0) return BLUE;
-    if (SafeStrNCaseCmp(tag_start, "yellow", 6) == 0) return YELLOW;
-    if (SafeStrNCaseCmp(tag_start, "purple", 6) == 0) return PURPLE;
-    if (SafeStrNCaseCmp(tag_start, "orange", 6) == 0) return ORANGE;
-    if (SafeStrNCaseCmp(tag_start, "darkblue", 8) == 0) return DARKBLUE;
-    if (SafeStrNCaseCmp(tag_start, "darkgray", 8) == 0) return DARKGRAY;
-    if (SafeStrNCaseCmp(tag_start, "maroon", 6) == 0) return MAROON;
-    if (SafeStrNCaseCmp(tag_start, "white", 5) == 0) return WHITE;
-    if (SafeStrNCaseCmp(tag_start, "black", 5) == 0) return BLACK;
-    if (SafeStrNCaseCmp(tag_start, "gray", 4) == 0) return GRAY;
-    
-    return RAYWHITE; // 預設顏色
+// 確保陣列容量足夠 (倍增擴充，保留既有容量以便重複使用)
+static bool ReserveArray(void** data, int* capacity, int needed, int elemSize)
+{
+    if (needed <= *capacity) return true;
+    int newCap = (*capacity > 0) ? *capacity : 64;
+    while (newCap < needed) newCap *= 2;
+    void* p = MemRealloc(*data, (unsigned int)(newCap * elemSize));
+    if (!p) return false;
+    *data = p;
+    *capacity = newCap;
+    return true;
 }
 
-// [NEW] 清空快取與圖集 (當空間不足時呼叫)
-static void FlushCache(void)
+// 切換本執行緒目前作用中的上下文，回傳原本的上下文 (公開函數結束時還原，允許巢狀呼叫)
+static AdvTextContext* BindContext(AdvTextContext* ctx)
 {
-    // 1. 清空 GPU 紋理 (填入全透明)
-    // 建立一個全空的緩衝區來重置紋理
-    void* clearData = calloc(ATLAS_SIZE * ATLAS_SIZE, 4); // RGBA * 4 bytes
-    if (clearData) {
-        UpdateTexture(g_ctx.atlas, clearData);
-        free(clearData);
-    }
+    AdvTextContext* prev = g_current;
+    g_current = ctx ? ctx : &g_defaultCtx;
+    return prev;
+}
 
-    // 2. 重置圖集游標
-    g_ctx.atlasX = 2;
-    g_ctx.atlasY = 2;
-    g_ctx.rowHeight = 0;
+// 取得快取鎖 (exclusive 為 true 時取寫鎖)；沒有執行緒支援或尚未初始化時不做事
+static void LockContext(bool exclusive)
+{
+#if defined(ADVTEXT_THREADS)
+    if (!g_ctx.lockReady) return;
+    if (exclusive) pthread_rwlock_wrlock(&g_ctx.cacheLock);
+    else pthread_rwlock_rdlock(&g_ctx.cacheLock);
+#else
+    (void)exclusive;
+#endif
+}
 
-    // 3. 重置所有快取資料
-    for (int i = 0; i < MAX_GLYPHS; i++) {
-        g_ctx.cache[i].active = false;
-        g_ctx.hashLookup[i] = -1; // -1 表示空
-    }
+static void UnlockContext(void)
+{
+#if defined(ADVTEXT_THREADS)
+    if (g_ctx.lockReady) pthread_rwlock_unlock(&g_ctx.cacheLock);
+#endif
+}
 
-    TraceLog(LOG_INFO, "AdvText: Cache flushed (Atlas full or Limit reached).");
+// 讀鎖換成寫鎖 (中間會短暫放開，期間其他執行緒可能已加入同一個字形，呼叫端需重新查詢)
+static void UpgradeContextLock(void)
+{
+    UnlockContext();
+    LockContext(true);
 }
 
-// [NEW] 取得字形 (核心優化：Hash Map + Auto Flush)
-static AdvGlyph* GetGlyph(int cp)
+static void DowngradeContextLock(void)
 {
-    // --- 步驟 1: 查表 (Hash Lookup) ---
-    // 使用簡單的模數雜湊
-    int hashIndex = cp % MAX_GLYPHS;
-    int step = 0;
+    UnlockContext();
+    LockContext(false);
+}
 
-    // 線性探測 (Linear Probing) 處裡碰撞
-    while (step < MAX_GLYPHS) {
-        int cacheIdx = g_ctx.hashLookup[hashIndex];
-        
-        // 若該位置為 -1，表示真的沒快取過
-        if (cacheIdx == -1) break;
+// 渲染執行緒的公開函數：切換到 ctx 並取寫鎖，回傳原本的上下文給 LeaveContext
+static AdvTextContext* EnterContext(AdvTextContext* ctx)
+{
+    AdvTextContext* prev = BindContext(ctx);
+    LockContext(true);
+    return prev;
+}
 
-        // 若找到了對應的 Codepoint 且該快取有效
-        if (g_ctx.cache[cacheIdx].active && g_ctx.cache[cacheIdx].codepoint == cp) {
-            return &g_ctx.cache[cacheIdx]; // 命中！直接回傳
-        }
+static void LeaveContext(AdvTextContext* prev)
+{
+    UnlockContext();
+    BindContext(prev);
+}
 
-        // 發生碰撞 (Collision)，找下一個位置
-        hashIndex = (hashIndex + 1) % MAX_GLYPHS;
-        step++;
+// 重置圖集頁的天際線 (整頁變成空的)
+// 只清掉 CPU 鏡像中用過的列；GPU 上殘留的舊像素不會被取樣，新字形上傳時會連同間距一起覆蓋
+static void ResetAtlasPage(AtlasPage* page)
+{
+    int usedRows = 0;
+    for (int i = 0; i < page->nodeCount; i++) {
+        if (page->skyline[i].y > usedRows) usedRows = page->skyline[i].y;
     }
+    if (page->pixels) memset(page->pixels, 0, (size_t)usedRows * ATLAS_SIZE);
+    page->dirtyX0 = page->dirtyY0 = ATLAS_SIZE;
+    page->dirtyX1 = page->dirtyY1 = 0;
 
-    // --- 步驟 2: 沒找到，準備新增字形 ---
-    
-    // 找一個空閒的快取插槽
-    int newIdx = -1;
-    // 這裡可以使用另一個變數追蹤最後使用的 index 來加速，目前先簡單遍歷
-    // 由於我們有 Hash Map，這裡通常不會很慢，除非快取快滿了
-    for (int i = 0; i < MAX_GLYPHS; i++) {
-        if (!g_ctx.cache[i].active) {
-            newIdx = i;
-            break;
-        }
+    page->skyline[0] = (SkylineNode){ 0, 0, ATLAS_SIZE };
+    page->nodeCount = 1;
+    page->usedArea = 0;
+}
+
+// 標記圖集頁中待上傳的區域 (與既有髒區合併)
+static void MarkAtlasDirty(AtlasPage* page, int x0, int y0, int x1, int y1)
+{
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > ATLAS_SIZE) x1 = ATLAS_SIZE;
+    if (y1 > ATLAS_SIZE) y1 = ATLAS_SIZE;
+    if (x0 < page->dirtyX0) page->dirtyX0 = x0;
+    if (y0 < page->dirtyY0) page->dirtyY0 = y0;
+    if (x1 > page->dirtyX1) page->dirtyX1 = x1;
+    if (y1 > page->dirtyY1) page->dirtyY1 = y1;
+}
+
+// 建立新的圖集頁 (已達上限回傳 NULL)
+// baked 不為 NULL 時以烘焙好的前 bakedRows 列 Alpha 像素建立
+// 只配置 CPU 鏡像：背景排版也可能建立新頁，GPU 紋理留到渲染執行緒上傳時才建立
+static AtlasPage* CreateAtlasPage(const unsigned char* baked, int bakedRows)
+{
+    if (g_ctx.pageCount >= MAX_ATLAS_PAGES) return NULL;
+
+    AtlasPage* page = &g_ctx.pages[g_ctx.pageCount];
+    page->pixels = (unsigned char*)MemAlloc(ATLAS_SIZE * ATLAS_SIZE);
+    if (!page->pixels) return NULL;
+    page->nodeCount = 0;
+    ResetAtlasPage(page);
+    page->texture = (Texture2D){ 0 };
+
+    if (baked && bakedRows > 0) {
+        memcpy(page->pixels, baked, (size_t)bakedRows * ATLAS_SIZE);
+        // 烘焙區以下才繼續打包新字形；烘焙像素隨第一次上傳送出
+        page->skyline[0].y = bakedRows;
+        page->usedArea = bakedRows * ATLAS_SIZE;
+        MarkAtlasDirty(page, 0, 0, ATLAS_SIZE, bakedRows);
     }
 
-    // 若快取陣列全滿 -> 強制清空 (Flush)
-    if (newIdx == -1) {
-        FlushCache();
-        return GetGlyph(cp); // 遞迴重試 (這時一定有空位)
+    if (g_ctx.pageCount > 0) {
+        const AtlasPage* prev = &g_ctx.pages[g_ctx.pageCount - 1];
+        TraceLog(LOG_INFO, "AdvText: Atlas page %d allocated (page %d packing efficiency %.1f%%)",
+                 g_ctx.pageCount, g_ctx.pageCount - 1, 100.0f * prev->usedArea / ((float)ATLAS_SIZE * ATLAS_SIZE));
     }
 
-    // --- 步驟 3: 使用 stb_truetype 產生字形 ---
-    int w, h, xoff, yoff, adv;
-    // 取得 Bitmap 與 Metrics
-    unsigned char* bmp = stbtt_GetCodepointBitmap(&g_ctx.info, 0, g_ctx.scale, cp, &w, &h, &xoff, &yoff);
-    stbtt_GetCodepointHMetrics(&g_ctx.info, cp, &adv, NULL);
+    g_ctx.pageCount++;
+    return page;
+}
 
-    // --- 步驟 4: 檢查圖集空間 ---
-    // 檢查水平空間
-    if (g_ctx.atlasX + w + 2 >= ATLAS_SIZE) {
-        g_ctx.atlasX = 2; // 換行
-        g_ctx.atlasY += g_ctx.rowHeight + 2;
-        g_ctx.rowHeight = 0;
-    }
+// 從第 i 個節點開始放寬 w、高 h 的矩形所需的 y，放不下回傳 -1
+static int SkylineFit(const AtlasPage* page, int i, int w, int h)
+{
+    if (page->skyline[i].x + w > ATLAS_SIZE) return -1;
 
-    // 檢查垂直空間 (圖集滿了?)
-    if (g_ctx.atlasY + h + 2 >= ATLAS_SIZE) {
-        if (bmp) stbtt_FreeBitmap(bmp, NULL);
-        FlushCache(); // 圖集滿了 -> 強制清空
-        return GetGlyph(cp); // 遞迴重試
+    int y = 0;
+    int remaining = w;
+    while (remaining > 0) {
+        if (page->skyline[i].y > y) y = page->skyline[i].y;
+        if (y + h > ATLAS_SIZE) return -1;
+        remaining -= page->skyline[i].width;
+        i++;
     }
+    return y;
+}
+
+// 天際線 Bottom-Left 打包：選擇放置後底部最低的位置，失敗回傳 false
+static bool SkylineAlloc(AtlasPage* page, int w, int h, int* outX, int* outY)
+{
+    int bestIdx = -1, bestBottom = ATLAS_SIZE + 1, bestWidth = ATLAS_SIZE + 1, bestY = 0;
 
-    // --- 步驟 5: 上傳像素到 GPU ---
-    if (w > 0 && h > 0) {
-        // stbtt 回傳的是單通道 (Alpha)，我們轉成 RGBA (白色 + Alpha)
-        unsigned char* px = (unsigned char*)MemAlloc(w * h * 4);
-        for (int i = 0; i < w * h; i++) {
-            px[i * 4] = 255;     // R
-            px[i * 4 + 1] = 255; // G
-            px[i * 4 + 2] = 255; // B
-            px[i * 4 + 3] = bmp[i]; // Alpha from font
+    for (int i = 0; i < page->nodeCount; i++) {
+        int y = SkylineFit(page, i, w, h);
+        if (y < 0) continue;
+        if (y + h < bestBottom || (y + h == bestBottom && page->skyline[i].width < bestWidth)) {
+            bestIdx = i;
+            bestBottom = y + h;
+            bestWidth = page->skyline[i].width;
+            bestY = y;
         }
-        
-        // 更新圖集局部區域
-        UpdateTextureRec(g_ctx.atlas, (Rectangle) { (float)g_ctx.atlasX, (float)g_ctx.atlasY, (float)w, (float)h }, px);
-        MemFree(px);
     }
-    
-    if (bmp) stbtt_FreeBitmap(bmp, NULL);
+    if (bestIdx == -1 || page->nodeCount >= ATLAS_SIZE) return false;
 
-    // --- 步驟 6: 寫入快取結構 ---
-    AdvGlyph* g = &g_ctx.cache[newIdx];
-    g->codepoint = cp;
-    g->srcRec = (Rectangle){ (float)g_ctx.atlasX, (float)g_ctx.atlasY, (float)w, (float)h };
-    g->bearingX = xoff;
-    g->bearingY = yoff;
-    g->advance = (int)(adv * g_ctx.scale);
-    g->active = true;
+    // 插入新節點，並裁掉被它蓋住的後續節點
+    SkylineNode* nodes = page->skyline;
+    int x = nodes[bestIdx].x;
+    memmove(&nodes[bestIdx + 1], &nodes[bestIdx], (page->nodeCount - bestIdx) * sizeof(SkylineNode));
+    nodes[bestIdx] = (SkylineNode){ x, bestY + h, w };
+    page->nodeCount++;
 
-    // --- 步驟 7: 更新 Hash Map ---
-    // 重新計算 Hash 位置 (因為可能經過線性探測)
-    hashIndex = cp % MAX_GLYPHS;
-    while (g_ctx.hashLookup[hashIndex] != -1) {
-        hashIndex = (hashIndex + 1) % MAX_GLYPHS;
+    int i = bestIdx + 1;
+    while (i < page->nodeCount && nodes[i].x < x + w) {
+        int shrink = x + w - nodes[i].x;
+        nodes[i].x += shrink;
+        nodes[i].width -= shrink;
+        if (nodes[i].width > 0) break;
+        memmove(&nodes[i], &nodes[i + 1], (page->nodeCount - i - 1) * sizeof(SkylineNode));
+        page->nodeCount--;
     }
-    g_ctx.hashLookup[hashIndex] = newIdx; // 紀錄 Codepoint 對應到的 Cache Index
 
-    // 更新圖集游標
-    g_ctx.atlasX += w + 2;
-    if (h > g_ctx.rowHeight) g_ctx.rowHeight = h;
+    // 合併相同高度的相鄰節點
+    for (i = 0; i < page->nodeCount - 1; ) {
+        if (nodes[i].y == nodes[i + 1].y) {
+            nodes[i].width += nodes[i + 1].width;
+            memmove(&nodes[i + 1], &nodes[i + 2], (page->nodeCount - i - 2) * sizeof(SkylineNode));
+            page->nodeCount--;
+        } else {
+            i++;
+        }
+    }
 
-    return g;
+    page->usedArea += w * h;
+    *outX = x;
+    *outY = bestY;
+    return true;
 }
 
-// -------------------------------------------------------------------------
-// 公開 API 實作
-// -------------------------------------------------------------------------
-
-void InitAdvText(const char* fontPath, int fontSize)
+// 把字形點陣寫入 CPU 鏡像 (整個 cell 先清空，回收的區域不會殘留舊字形)
+static void WriteGlyphPixels(AtlasPage* page, Rectangle cell, const unsigned char* bmp, int bw, int bh, int stride)
 {
-    if (g_ctx.loaded) UnloadAdvText(); // 防止重複初始化
-
-    int size;
-    g_ctx.fontData = LoadFileData(fontPath, &size);
-    if (!g_ctx.fontData) {
-        TraceLog(LOG_WARNING, "AdvText: Failed to load font data from %s", fontPath);
-        return;
-    }
+    int cx = (int)cell.x, cy = (int)cell.y;
+    int cw = (int)cell.width, ch = (int)cell.height;
 
-    if (!stbtt_InitFont(&g_ctx.info, g_ctx.fontData, 0)) {
-        TraceLog(LOG_ERROR, "AdvText: Failed to init stbtt font");
-        UnloadFileData(g_ctx.fontData);
-        return;
+    for (int y = 0; y < ch; y++) {
+        unsigned char* row = &page->pixels[(size_t)(cy + y) * ATLAS_SIZE + cx];
+        if (y < bh) {
+            memcpy(row, &bmp[y * stride], bw);
+            memset(row + bw, 0, cw - bw);
+        } else {
+            memset(row, 0, cw);
+        }
     }
 
-    // 計算字型度量
-    g_ctx.scale = stbtt_ScaleForPixelHeight(&g_ctx.info, (float)fontSize);
-    stbtt_GetFontVMetrics(&g_ctx.info, &g_ctx.ascent, &g_ctx.descent, &g_ctx.lineGap);
-    g_ctx.ascent = (int)(g_ctx.ascent * g_ctx.scale);
-    g_ctx.descent = (int)(g_ctx.descent * g_ctx.scale);
-    g_ctx.lineGap = (int)(g_ctx.lineGap * g_ctx.scale);
-
-    // 建立紋理圖集
-    Image img = GenImageColor(ATLAS_SIZE, ATLAS_SIZE, BLANK);
-    g_ctx.atlas = LoadTextureFromImage(img);
-    SetTextureFilter(g_ctx.atlas, TEXTURE_FILTER_BILINEAR);
-    UnloadImage(img);
-
-    // 初始化狀態
-    g_ctx.atlasX = 2;
-    g_ctx.atlasY = 2;
-    g_ctx.rowHeight = 0;
-    
-    // 初始化雜湊表 (-1 代表空)
-    for(int i=0; i<MAX_GLYPHS; i++) g_ctx.hashLookup[i] = -1;
-    memset(g_ctx.cache, 0, sizeof(g_ctx.cache));
-
-    g_ctx.loaded = true;
-    TraceLog(LOG_INFO, "AdvText: Initialized with font %s size %d (Atlas: %dx%d)", fontPath, fontSize, ATLAS_SIZE, ATLAS_SIZE);
+    // 連同四周間距一起上傳，覆蓋 GPU 上可能殘留的舊像素
+    int pad = ATLAS_PADDING / 2;
+    MarkAtlasDirty(page, cx - pad, cy - pad, cx + cw + pad, cy + ch + pad);
 }
 
-void UnloadAdvText(void)
+// Alpha -> RGBA (白色 + Alpha)：SSE2 / NEON 每次展開 16 個像素，剩下的逐個處理
+static void ExpandAlphaToRGBA(unsigned char* dst, const unsigned char* src, int count)
 {
-    if (g_ctx.loaded) {
-        UnloadTexture(g_ctx.atlas);
-        UnloadFileData(g_ctx.fontData);
-        g_ctx.fontData = NULL;
-        g_ctx.loaded = false;
-        TraceLog(LOG_INFO, "AdvText: Unloaded");
+    int i = 0;
+#if defined(ADVTEXT_SSE2)
+    const __m128i white = _mm_set1_epi8((char)0xFF);
+    for (; i + 16 <= count; i += 16) {
+        __m128i alpha = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i lo = _mm_unpacklo_epi8(white, alpha); // FF a0 FF a1 ...
+        __m128i hi = _mm_unpackhi_epi8(white, alpha);
+        _mm_storeu_si128((__m128i*)&dst[i * 4], _mm_unpacklo_epi16(white, lo)); // FF FF FF a0 ...
+        _mm_storeu_si128((__m128i*)&dst[i * 4 + 16], _mm_unpackhi_epi16(white, lo));
+        _mm_storeu_si128((__m128i*)&dst[i * 4 + 32], _mm_unpacklo_epi16(white, hi));
+        _mm_storeu_si128((__m128i*)&dst[i * 4 + 48], _mm_unpackhi_epi16(white, hi));
+    }
+#elif defined(ADVTEXT_NEON)
+    uint8x16x4_t px;
+    px.val[0] = px.val[1] = px.val[2] = vdupq_n_u8(255);
+    for (; i + 16 <= count; i += 16) {
+        px.val[3] = vld1q_u8(&src[i]);
+        vst4q_u8(&dst[i * 4], px); // 交錯寫回 R G B A
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i * 4 + 0] = 255;    // R
+        dst[i * 4 + 1] = 255;    // G
+        dst[i * 4 + 2] = 255;    // B
+        dst[i * 4 + 3] = src[i]; // Alpha from font
     }
 }
 
-// 核心繪製函數
-void DrawRichTextStyled(const char* text, Vector2 pos, int charLimit, AdvTextStyle style)
+// 把所有圖集頁的髒區上傳到 GPU (每頁合併成一個矩形，必須在送出使用圖集的繪製之前呼叫)
+static void UploadAtlasPages(void)
 {
-    if (!g_ctx.loaded || !text) return;
+    for (int p = 0; p < g_ctx.pageCount; p++) {
+        AtlasPage* page = &g_ctx.pages[p];
+        if (page->dirtyX0 >= page->dirtyX1 || page->dirtyY0 >= page->dirtyY1) continue;
+        if (g_ctx.flags & ADVTEXT_FLAG_HEADLESS) {
+            page->dirtyX0 = page->dirtyY0 = ATLAS_SIZE; // 沒有紋理可上傳，鏡像就是唯一的圖集
+            page->dirtyX1 = page->dirtyY1 = 0;
+            continue;
+        }
 
-    // 預設值保護
-    if (style.bgPaddingX == 0) style.bgPaddingX = 8.0f;
-    if (style.bgPaddingY == 0) style.bgPaddingY = 6.0f;
-    if (style.outlineThickness == 0) style.outlineThickness = 1.0f;
-    if (style.lineSpacing == 0) style.lineSpacing = 1.0f;
+        // 第一次上傳時才建立紋理 (建立圖集頁的可能是背景排版執行緒)
+        if (page->texture.id == 0) {
+            Image img = GenImageColor(ATLAS_SIZE, ATLAS_SIZE, BLANK);
+            page->texture = LoadTextureFromImage(img);
+            SetTextureFilter(page->texture, TEXTURE_FILTER_BILINEAR);
+            UnloadImage(img);
+        }
 
-    float lineHeight = (float)(g_ctx.ascent - g_ctx.descent + g_ctx.lineGap) * style.lineSpacing;
-    float maxLineW = 0.0f;
-    float totalH = 0.0f;
-
-    // ---------------------------------------------------------------------
-    // 第一階段：預掃描 (Pre-scan)
-    // 計算整體尺寸，用於繪製 Global Background
-    // [FIX] 這裡移除了 charLimit 的限制，確保背景框總是顯示「全文」的大小
-    // ---------------------------------------------------------------------
-    {
-        int scanIdx = 0;
-        float curY = pos.y;
-        
-        while (text[scanIdx]) {
-            float lineW = 0.0f;
-            int lineScan = scanIdx;
-            bool forcedNL = false;
-
-            while (text[lineScan]) {
-                // 處理標籤 (跳過不計寬度)
-                if (text[lineScan] == '[') {
-                    if (strncmp(&text[lineScan], "[/color]", 8) == 0) {
-                        lineScan += 8; continue;
-                    }
-                    if (strncmp(&text[lineScan], "[color=", 7) == 0) {
-                        char* end = strchr(&text[lineScan + 7], ']');
-                        if (end) {
-                            lineScan = (int)(end - text) + 1; continue;
-                        }
-                    }
-                }
+        int x0 = page->dirtyX0, w = page->dirtyX1 - page->dirtyX0;
+        if (!g_ctx.uploadBuffer) {
+            g_ctx.uploadBuffer = (unsigned char*)MemAlloc(ATLAS_SIZE * ATLAS_UPLOAD_ROWS * 4);
+            if (!g_ctx.uploadBuffer) return;
+        }
 
-                int bytes = 0;
-                int cp = GetCodepointNext(&text[lineScan], &bytes);
-                
-                if (cp == 0) break;
-                if (cp == '\n') {
-                    forcedNL = true;
-                    lineScan += bytes;
-                    break;
-                }
+        // 分段上傳，限制暫存緩衝區大小
+        for (int y0 = page->dirtyY0; y0 < page->dirtyY1; y0 += ATLAS_UPLOAD_ROWS) {
+            int rows = page->dirtyY1 - y0;
+            if (rows > ATLAS_UPLOAD_ROWS) rows = ATLAS_UPLOAD_ROWS;
 
-                AdvGlyph* g = GetGlyph(cp);
-                if (g) {
-                    // 自動換行檢查
-                    if (style.maxWidth > 0 && lineW + g->advance > style.maxWidth) {
-                        break; // 此行結束，雖然還沒遇到 \n
-                    }
-                    lineW += g->advance;
-                }
-                lineScan += bytes;
+            // 鏡像是單通道 (Alpha)，我們轉成 RGBA (白色 + Alpha)
+            for (int y = 0; y < rows; y++) {
+                ExpandAlphaToRGBA(&g_ctx.uploadBuffer[(size_t)y * w * 4], &page->pixels[(size_t)(y0 + y) * ATLAS_SIZE + x0], w);
             }
+            UpdateTextureRec(page->texture, (Rectangle){ (float)x0, (float)y0, (float)w, (float)rows }, g_ctx.uploadBuffer);
+            STAT_ADD(uploadBytes, (unsigned long long)w * rows * 4);
+        }
 
-            if (lineW > maxLineW) maxLineW = lineW;
-            totalH += lineHeight;
+        page->dirtyX0 = page->dirtyY0 = ATLAS_SIZE;
+        page->dirtyX1 = page->dirtyY1 = 0;
+    }
+}
 
-            scanIdx = lineScan;
-        }
+// 閒置插槽堆疊重置為全部閒置 (插槽 0 最先取出)
+static void ResetFreeSlots(void)
+{
+    g_ctx.freeSlotCount = 0;
+    for (int i = MAX_GLYPHS - 1; i >= 0; i--) {
+        if (!g_ctx.cache[i].active) g_ctx.freeSlots[g_ctx.freeSlotCount++] = i;
     }
+}
 
-    // ---------------------------------------------------------------------
-    // 繪製 Global Background (如果啟用)
-    // ---------------------------------------------------------------------
-    if (style.enableBackground && style.enableGlobalBackground && maxLineW > 0) {
-        float bgW = maxLineW + style.bgPaddingX * 2;
-        float bgH = totalH + style.bgPaddingY * 2;
-        float bgX = pos.x - bgW / 2.0f; // 預設 Center Align 的背景位置
-
-        if (style.align == TEXT_ALIGN_LEFT)
-            bgX = pos.x - style.bgPaddingX;
-        else if (style.align == TEXT_ALIGN_RIGHT)
-            bgX = pos.x - bgW + style.bgPaddingX;
-
-        Rectangle bgRec = { bgX, pos.y - style.bgPaddingY, bgW, bgH };
-        DrawRectangleRounded(bgRec, 0.1f, 8, style.backgroundColor);
-    }
-
-    // ---------------------------------------------------------------------
-    // 第二階段：正式繪製文字
-    // ---------------------------------------------------------------------
-    float curY = pos.y;
-    Color curColor = style.baseColor;
-    int displayedChars = 0; // 已顯示的可見字元計數
-    int idx = 0;
+// 清空 LRU 鏈 (插槽全部閒置時)
+static void ResetGlyphLru(void)
+{
+    g_ctx.lruHead = g_ctx.lruTail = -1;
+}
 
-    while (text[idx] && (charLimit < 0 || displayedChars < charLimit)) {
-        float lineW = 0.0f;
-        int lineStartIdx = idx;
-        int lineCharCount = 0; // 這行的可見字元數
-        Color tempColor = curColor; // 暫存顏色狀態給寬度計算用
-        bool forcedNewline = false;
-
-        // 2.1 掃描當前行 (計算寬度與換行點)
-        int scan = idx;
-        while (text[scan]) {
-            // 標籤處理
-            if (text[scan] == '[') {
-                if (strncmp(&text[scan], "[/color]", 8) == 0) {
-                    tempColor = style.baseColor;
-                    scan += 8; continue;
-                }
-                if (strncmp(&text[scan], "[color=", 7) == 0) {
-                    char* end = strchr(&text[scan + 7], ']');
-                    if (end) {
-                        tempColor = GetTagColor(&text[scan + 7]);
-                        scan = (int)(end - text) + 1; continue;
-                    }
-                }
-            }
+// 把插槽從 LRU 鏈上拿下
+static void LruUnlink(int idx)
+{
+    AdvGlyph* g = &g_ctx.cache[idx];
+    if (g->lruPrev != -1) g_ctx.cache[g->lruPrev].lruNext = g->lruNext;
+    else g_ctx.lruHead = g->lruNext;
+    if (g->lruNext != -1) g_ctx.cache[g->lruNext].lruPrev = g->lruPrev;
+    else g_ctx.lruTail = g->lruPrev;
+    g->lruPrev = g->lruNext = -1;
+}
 
-            int bytes = 0;
-            int cp = GetCodepointNext(&text[scan], &bytes);
-            if (cp == 0) break;
-            if (cp == '\n') {
-                forcedNewline = true;
-                scan += bytes;
-                break;
-            }
+// 放到 LRU 鏈開頭 (最近使用)
+static void LruPushFront(int idx)
+{
+    AdvGlyph* g = &g_ctx.cache[idx];
+    g->lruPrev = -1;
+    g->lruNext = g_ctx.lruHead;
+    if (g_ctx.lruHead != -1) g_ctx.cache[g_ctx.lruHead].lruPrev = idx;
+    else g_ctx.lruTail = idx;
+    g_ctx.lruHead = idx;
+}
+
+// 放到 LRU 鏈尾端 (下一個回收對象)
+static void LruPushBack(int idx)
+{
+    AdvGlyph* g = &g_ctx.cache[idx];
+    g->lruNext = -1;
+    g->lruPrev = g_ctx.lruTail;
+    if (g_ctx.lruTail != -1) g_ctx.cache[g_ctx.lruTail].lruNext = idx;
+    else g_ctx.lruHead = idx;
+    g_ctx.lruTail = idx;
+}
 
-            AdvGlyph* g = GetGlyph(cp);
-            if (!g) { scan += bytes; continue; }
+// 標記字形本幀使用 (釘住)：本幀第一次用到時移到 LRU 鏈開頭，之後的命中只比對幀編號
+static void TouchGlyph(AdvGlyph* g)
+{
+    if (g->lastUsed == g_ctx.frame) return;
+    g->lastUsed = g_ctx.frame;
+    int idx = (int)(g - g_ctx.cache);
+    LruUnlink(idx);
+    LruPushFront(idx);
+}
 
-            // 打字機限制：這裡只用於判斷換行邏輯是否因為還沒打出來的字而改變
-            // 但標準做法是排版應該是固定的，所以這裡不該受 charLimit 影響換行位置
-            // 我們只判斷寬度自動換行
-            if (style.maxWidth > 0 && lineW + g->advance > style.maxWidth) {
-                break; 
-            }
+// 清空字形索引 (保留索引頁陣列的容量)
+static void ClearGlyphIndex(void)
+{
+    for (int f = 0; f < GLYPH_FACE_COUNT; f++) MemFree(g_ctx.faces[f].dir);
+    memset(g_ctx.faces, 0, sizeof(g_ctx.faces));
+    g_ctx.indexPageCount = 0;
+    g_ctx.freeIndexPage = -1;
+}
 
-            lineW += g->advance;
-            lineCharCount++;
-            scan += bytes;
-        }
+// 查表：回傳快取索引，找不到回傳 -1 (兩次陣列索引，沒有探測鏈)
+static int GlyphIndexFind(unsigned int key)
+{
+    const GlyphFace* face = &g_ctx.faces[key >> 21];
+    unsigned int cp = key & 0x1FFFFF;
+    if (!face->dir || cp >= 0x110000) return -1;
+    unsigned short page = face->dir[cp >> 8];
+    if (page == 0) return -1;
+    return g_ctx.indexPages[page - 1].slots[cp & 0xFF];
+}
 
-        // 2.2 計算對齊偏移
-        float offX = 0.0f;
-        if (style.align == TEXT_ALIGN_CENTER) offX = -lineW / 2.0f;
-        else if (style.align == TEXT_ALIGN_RIGHT) offX = -lineW;
+// 加入索引 (目錄與索引頁在第一次用到時配置)，配置失敗回傳 false
+static bool GlyphIndexInsert(unsigned int key, int cacheIdx)
+{
+    GlyphFace* face = &g_ctx.faces[key >> 21];
+    unsigned int cp = key & 0x1FFFFF;
+    if (cp >= 0x110000) return false;
 
-        float startX = pos.x + offX;
+    if (!face->dir) {
+        face->dir = (unsigned short*)MemAlloc(GLYPH_DIR_SIZE * sizeof(unsigned short));
+        if (!face->dir) return false;
+    }
 
-        // 2.3 繪製行背景 (如果未啟用 Global Background)
-        if (style.enableBackground && !style.enableGlobalBackground) {
-            DrawRectangleRounded(
-                (Rectangle) { startX - style.bgPaddingX, curY - style.bgPaddingY, lineW + style.bgPaddingX * 2, lineHeight + style.bgPaddingY * 2 },
-                0.2f, 4, style.backgroundColor);
+    unsigned short* entry = &face->dir[cp >> 8];
+    if (*entry == 0) {
+        int page = g_ctx.freeIndexPage;
+        if (page >= 0) {
+            g_ctx.freeIndexPage = g_ctx.indexPages[page].slots[0];
+        } else {
+            if (!ReserveArray((void**)&g_ctx.indexPages, &g_ctx.indexPageCapacity, g_ctx.indexPageCount + 1, sizeof(GlyphIndexPage))) return false;
+            page = g_ctx.indexPageCount++;
         }
+        GlyphIndexPage* p = &g_ctx.indexPages[page];
+        for (int i = 0; i < GLYPH_INDEX_PAGE_SIZE; i++) p->slots[i] = -1;
+        p->used = 0;
+        *entry = (unsigned short)(page + 1);
+        face->pageCount++;
+    }
 
-        // 2.4 逐字繪製
-        float drawX = startX;
-        idx = lineStartIdx; // 回到行首開始畫
-        
-        while (idx < scan && (charLimit < 0 || displayedChars < charLimit)) {
-            // 標籤處理 (真正改變顏色)
-            if (text[idx] == '[') {
-                if (strncmp(&text[idx], "[/color]", 8) == 0) {
-                    curColor = style.baseColor;
-                    idx += 8; continue;
-                }
-                if (strncmp(&text[idx], "[color=", 7) == 0) {
-                    char* end = strchr(&text[idx + 7], ']');
-                    if (end) {
-                        curColor = GetTagColor(&text[idx + 7]);
-                        idx = (int)(end - text) + 1; continue;
-                    }
-                }
-            }
+    GlyphIndexPage* p = &g_ctx.indexPages[*entry - 1];
+    if (p->slots[cp & 0xFF] == -1) p->used++;
+    p->slots[cp & 0xFF] = cacheIdx;
+    return true;
+}
 
-            int bytes = 0;
-            int cp = GetCodepointNext(&text[idx], &bytes);
-            
-            // 換行符號不畫，但前面已經在 scan 迴圈處理過了，這裡主要是防禦
-            if (cp == '\n') { idx += bytes; break; }
+// 從索引移除：頁空了交回閒置鏈，face 沒有頁了就釋放目錄
+static void GlyphIndexRemove(unsigned int key)
+{
+    GlyphFace* face = &g_ctx.faces[key >> 21];
+    unsigned int cp = key & 0x1FFFFF;
+    if (!face->dir || cp >= 0x110000) return;
+
+    unsigned short* entry = &face->dir[cp >> 8];
+    if (*entry == 0) return;
+    int page = *entry - 1;
+    GlyphIndexPage* p = &g_ctx.indexPages[page];
+    if (p->slots[cp & 0xFF] == -1) return;
+
+    p->slots[cp & 0xFF] = -1;
+    if (--p->used > 0) return;
+
+    p->slots[0] = g_ctx.freeIndexPage;
+    g_ctx.freeIndexPage = page;
+    *entry = 0;
+    if (--face->pageCount == 0) {
+        MemFree(face->dir);
+        face->dir = NULL;
+    }
+}
+
+// 清空閒置區域 (所有節點回到閒置鏈)
+static void ResetFreeCells(void)
+{
+    for (int b = 0; b < FREE_CELL_BUCKETS; b++) g_ctx.freeCellBuckets[b] = -1;
+    for (int i = 0; i < MAX_GLYPHS; i++) g_ctx.freeCells[i].next = i + 1;
+    g_ctx.freeCells[MAX_GLYPHS - 1].next = -1;
+    g_ctx.freeCellPool = 0;
+}
+
+// 回收字形時把沒有被沿用的圖集區域交回 (節點用完時放棄這塊區域，留到 Flush 重置)
+static void ReleaseAtlasCell(int page, Rectangle cell)
+{
+    if (cell.width <= 0 || cell.height <= 0 || g_ctx.freeCellPool < 0) return;
+    int n = g_ctx.freeCellPool;
+    AtlasFreeCell* fc = &g_ctx.freeCells[n];
+    g_ctx.freeCellPool = fc->next;
+    int b = FREE_CELL_BUCKET((int)cell.height);
+    *fc = (AtlasFreeCell){ cell, page, g_ctx.freeCellBuckets[b] };
+    g_ctx.freeCellBuckets[b] = n;
+}
+
+// 取出容得下 w x h 的閒置區域 (從高度相近的桶找起，取第一個放得下的)
+static bool TakeAtlasCell(int w, int h, int* outPage, Rectangle* outCell)
+{
+    int first = FREE_CELL_BUCKET(h);
+    for (int b = first; b < FREE_CELL_BUCKETS && b <= first + FREE_CELL_SEARCH; b++) {
+        for (int* link = &g_ctx.freeCellBuckets[b]; *link != -1; link = &g_ctx.freeCells[*link].next) {
+            AtlasFreeCell* fc = &g_ctx.freeCells[*link];
+            if (fc->cell.width < w || fc->cell.height < h) continue;
+            int n = *link;
+            *link = fc->next;
+            *outPage = fc->page;
+            *outCell = fc->cell;
+            fc->next = g_ctx.freeCellPool;
+            g_ctx.freeCellPool = n;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 丟棄位於 pageMask 中的圖集頁的閒置區域 (整頁重置時)
+static void DropFreeCells(unsigned int pageMask)
+{
+    for (int b = 0; b < FREE_CELL_BUCKETS; b++) {
+        int* link = &g_ctx.freeCellBuckets[b];
+        while (*link != -1) {
+            int n = *link;
+            if (!(pageMask & (1u << g_ctx.freeCells[n].page))) {
+                link = &g_ctx.freeCells[n].next;
+                continue;
+            }
+            *link = g_ctx.freeCells[n].next;
+            g_ctx.freeCells[n].next = g_ctx.freeCellPool;
+            g_ctx.freeCellPool = n;
+        }
+    }
+}
+
+// [NEW] 清空快取與圖集 (未呼叫 BeginAdvTextFrame 而空間不足時呼叫)
+static void FlushCache(void)
+{
+    // 1. 重置天際線並清掉 CPU 鏡像用過的區域 (不需要上傳整張空白紋理)
+    for (int p = 0; p < g_ctx.pageCount; p++) ResetAtlasPage(&g_ctx.pages[p]);
+
+    // 2. 重置所有快取資料
+    for (int i = 0; i < MAX_GLYPHS; i++) {
+        g_ctx.cache[i].active = false;
+        g_ctx.cache[i].serial++;
+    }
+    ResetFreeSlots();
+    ResetGlyphLru();
+    ResetFreeCells();
+    ClearGlyphIndex();
+
+    g_ctx.flushCount++;
+    STAT_ADD(flushes, 1);
+
+    TraceLog(LOG_INFO, "AdvText: Cache flushed (no frame boundary, all glyphs and atlas pages reset).");
+}
+
+// 只清空沒有本幀字形的圖集頁 (本幀已送出的繪製還在取樣其他頁，那些頁不能重置)
+// 回傳是否騰出了圖集頁
+static bool FlushUnpinnedPages(void)
+{
+    unsigned int pinned = 0;
+    for (int i = 0; i < MAX_GLYPHS; i++) {
+        const AdvGlyph* g = &g_ctx.cache[i];
+        if (g->active && g->lastUsed == g_ctx.frame && g->cell.width > 0) pinned |= 1u << g->page;
+    }
+
+    unsigned int reset = 0;
+    for (int p = 0; p < g_ctx.pageCount; p++) {
+        if (pinned & (1u << p)) continue;
+        ResetAtlasPage(&g_ctx.pages[p]);
+        reset |= 1u << p;
+    }
+
+    int freed = 0;
+    for (int i = 0; i < MAX_GLYPHS; i++) {
+        AdvGlyph* g = &g_ctx.cache[i];
+        if (!g->active || g->cell.width <= 0 || !(reset & (1u << g->page))) continue;
+        GlyphIndexRemove(g->key);
+        LruUnlink(i);
+        g->active = false;
+        g->serial++;
+        g_ctx.freeSlots[g_ctx.freeSlotCount++] = i;
+        freed++;
+    }
+    DropFreeCells(reset);
+    if (reset == 0) return false;
+
+    int pages = 0;
+    for (int p = 0; p < g_ctx.pageCount; p++) if (reset & (1u << p)) pages++;
+    STAT_ADD(flushes, 1);
+    TraceLog(LOG_INFO, "AdvText: Cache flushed %d unpinned atlas page(s), %d glyphs released", pages, freed);
+    return true;
+}
+
+// 從 LRU 尾端找出最久未使用且可回收的字形 (本幀用過的字形被釘住，已送出的繪製不會失效)
+// minW/minH > 0 時往前最多看 EVICT_SEARCH 個冷字形，只考慮圖集區域容得下新字形者；回傳 -1 表示沒有可回收的字形
+static int FindEvictionVictim(int minW, int minH)
+{
+    int idx = g_ctx.lruTail;
+    for (int n = 0; idx != -1 && n < EVICT_SEARCH; n++, idx = g_ctx.cache[idx].lruPrev) {
+        const AdvGlyph* g = &g_ctx.cache[idx];
+        if (g->lastUsed == g_ctx.frame) break; // 鏈依 lastUsed 排列：之前的字形都被釘住
+        if (g->cell.width >= minW && g->cell.height >= minH) return idx;
+    }
+    return -1;
+}
+
+// 回收單一字形 (只有引用這個插槽的排版在下次繪製時重新取得字形)
+static void EvictGlyph(int idx)
+{
+    GlyphIndexRemove(g_ctx.cache[idx].key);
+    LruUnlink(idx);
+    g_ctx.cache[idx].active = false;
+    g_ctx.cache[idx].serial++;
+    STAT_ADD(evictions, 1);
+}
+
+// 讓字形再也查不到，但保留插槽與圖集區域 (標為最久未用，LRU 會最先回收並沿用其區域)
+static void RetireGlyph(int idx)
+{
+    AdvGlyph* g = &g_ctx.cache[idx];
+    GlyphIndexRemove(g->key);
+    g->key = RETIRED_GLYPH_KEY;
+    g->lastUsed = g_ctx.frame - 0x80000000u;
+    g->serial++;
+    LruUnlink(idx);
+    LruPushBack(idx);
+}
+
+// 配置一塊圖集區域：先用回收留下的閒置區域，再從現有圖集頁打包，都放不下時建立新頁；全部滿了回傳 false
+static bool AllocAtlasSpace(int w, int h, int* outPage, Rectangle* outCell)
+{
+    if (TakeAtlasCell(w, h, outPage, outCell)) return true;
+
+    int x, y;
+    for (int p = 0; p <= g_ctx.pageCount && p < MAX_ATLAS_PAGES; p++) {
+        if (p == g_ctx.pageCount && !CreateAtlasPage(NULL, 0)) break;
+        if (SkylineAlloc(&g_ctx.pages[p], w + ATLAS_PADDING, h + ATLAS_PADDING, &x, &y)) {
+            *outPage = p;
+            *outCell = (Rectangle){ (float)(x + ATLAS_PADDING / 2), (float)(y + ATLAS_PADDING / 2), (float)w, (float)h };
+            return true;
+        }
+    }
+    return false;
+}
+
+// 為新字形取得快取插槽與圖集區域，只回收冷字形；全部被釘住時回傳 false
+static bool AllocGlyphSpace(int w, int h, int* outIdx, int* outPage, Rectangle* outCell)
+{
+    // 閒置插槽堆疊的頂端 (確定使用時才取出)
+    int idx = (g_ctx.freeSlotCount > 0) ? g_ctx.freeSlots[g_ctx.freeSlotCount - 1] : -1;
+
+    // 空白字形 (如空格) 不佔圖集空間，只需要插槽
+    if (w == 0 || h == 0) {
+        if (idx != -1) g_ctx.freeSlotCount--;
+        else idx = FindEvictionVictim(0, 0);
+        if (idx == -1) return false;
+        if (g_ctx.cache[idx].active) {
+            ReleaseAtlasCell(g_ctx.cache[idx].page, g_ctx.cache[idx].cell);
+            EvictGlyph(idx);
+        }
+        *outIdx = idx;
+        *outPage = 0;
+        *outCell = (Rectangle){ 0 };
+        return true;
+    }
+
+    // 1. 有空插槽且圖集還有空間 (必要時建立新頁)
+    if (idx != -1 && AllocAtlasSpace(w, h, outPage, outCell)) {
+        g_ctx.freeSlotCount--;
+        *outIdx = idx;
+        return true;
+    }
+
+    // 2. 回收一個圖集區域容得下新字形的冷字形，沿用其插槽與區域
+    int victim = FindEvictionVictim(w, h);
+    if (victim != -1) {
+        *outPage = g_ctx.cache[victim].page;
+        *outCell = g_ctx.cache[victim].cell;
+        EvictGlyph(victim);
+        *outIdx = victim;
+        return true;
+    }
+
+    // 3. 插槽滿但圖集還有空間：回收最久未用的插槽 (容不下新字形的區域交回閒置區域，之後給較小的字形)
+    if (idx == -1) {
+        victim = FindEvictionVictim(0, 0);
+        if (victim != -1 && AllocAtlasSpace(w, h, outPage, outCell)) {
+            ReleaseAtlasCell(g_ctx.cache[victim].page, g_ctx.cache[victim].cell);
+            EvictGlyph(victim);
+            *outIdx = victim;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// 把點陣寫入字形的圖集區域並標記為可繪製
+static void CommitGlyphBitmap(AdvGlyph* g, const unsigned char* bmp, int bw, int bh)
+{
+    if (!bmp) bw = bh = 0;
+    if (bw > (int)g->cell.width) bw = (int)g->cell.width;
+    if (bh > (int)g->cell.height) bh = (int)g->cell.height;
+
+    // 寫入 CPU 鏡像 (延後到繪製前才合併上傳 GPU)
+    if (g->cell.width > 0 && g->cell.height > 0) {
+        WriteGlyphPixels(&g_ctx.pages[g->page], g->cell, bmp, bw, bh, bw);
+    }
+
+    g->srcRec = (Rectangle){ g->cell.x, g->cell.y, (float)bw, (float)bh };
+    g->ready = true;
+    g->serial++; // 預載時取得的排版在繪製前改用就緒的圖集位置
+}
+
+// 一條線上的滑動最大值 (van Herk / Gil-Werman)：輸出第 x 個為輸入 [x - 2r, x] 的最大值 (界外為 0)，共 n + 2r 個
+// 以 2r + 1 為區塊記錄區塊內的前綴與後綴最大值，每個輸出只取兩者較大者，成本與 r 無關
+// pre、suf 至少 n + 4r 個位元組；src、dst 的間隔讓同一個函數也能處理直行
+static void RunningMaxLine(const unsigned char* src, int n, int srcStride, int r, unsigned char* dst, int dstStride,
+                           unsigned char* pre, unsigned char* suf)
+{
+    int k = 2 * r + 1, len = n + 4 * r;
+    for (int j = 0; j < len; j++) {
+        int s = j - 2 * r;
+        unsigned char v = (s >= 0 && s < n) ? src[s * srcStride] : 0;
+        pre[j] = (j % k == 0 || v > pre[j - 1]) ? v : pre[j - 1];
+    }
+    for (int j = len - 1; j >= 0; j--) {
+        int s = j - 2 * r;
+        unsigned char v = (s >= 0 && s < n) ? src[s * srcStride] : 0;
+        suf[j] = (j % k == k - 1 || j == len - 1 || v > suf[j + 1]) ? v : suf[j + 1];
+    }
+    for (int x = 0; x < n + 2 * r; x++) {
+        unsigned char a = suf[x], b = pre[x + k - 1];
+        dst[x * dstStride] = (a > b) ? a : b;
+    }
+}
+
+// 從本執行緒的點陣化暫存區切出一塊 (前面 RASTER_ARENA_ALIGN 個位元組記錄來源)
+// 放不下時改用 MemAlloc 並掛在 overflow 上，重置時一起釋放並把暫存區擴大到足夠的大小
+static void* RasterArenaAlloc(size_t size)
+{
+    RasterArena* arena = g_rasterArena;
+    size_t need = RASTER_ARENA_ALIGN + ((size + RASTER_ARENA_ALIGN - 1) & ~(size_t)(RASTER_ARENA_ALIGN - 1));
+    RasterArenaHeader* header = NULL;
+    if (arena) {
+        arena->demand += need;
+        if (arena->used + need <= arena->size) {
+            header = (RasterArenaHeader*)(arena->base + arena->used);
+            arena->used += need;
+            header->kind = 0;
+            return (unsigned char*)header + RASTER_ARENA_ALIGN;
+        }
+    }
+
+    header = (RasterArenaHeader*)MemAlloc((unsigned int)need);
+    if (!header) return NULL;
+    header->kind = arena ? 1 : 2;
+    if (arena) {
+        header->next = arena->overflow;
+        arena->overflow = header;
+    }
+    return (unsigned char*)header + RASTER_ARENA_ALIGN;
+}
+
+// 暫存區內與 overflow 的區塊在重置時一起回收，只有沒有暫存區時的配置需要個別釋放
+static void RasterArenaFree(void* ptr)
+{
+    if (!ptr) return;
+    RasterArenaHeader* header = (RasterArenaHeader*)((unsigned char*)ptr - RASTER_ARENA_ALIGN);
+    if (header->kind == 2) MemFree(header);
+}
+
+// 切換本執行緒的點陣化暫存區，回傳原本的暫存區
+static RasterArena* BindRasterArena(RasterArena* arena)
+{
+    RasterArena* prev = g_rasterArena;
+    g_rasterArena = arena;
+    return prev;
+}
+
+// 一個字形點陣化完成 (點陣已寫入圖集或複製出去)：整個重置；這個字形放不下時擴大到它的用量
+static void ResetRasterArena(RasterArena* arena)
+{
+    while (arena->overflow) {
+        RasterArenaHeader* header = (RasterArenaHeader*)arena->overflow;
+        arena->overflow = header->next;
+        MemFree(header);
+    }
+    if (arena->demand > arena->size) {
+        size_t size = (arena->demand + RASTER_ARENA_GRANULARITY - 1) / RASTER_ARENA_GRANULARITY * RASTER_ARENA_GRANULARITY;
+        MemFree(arena->base);
+        arena->base = (unsigned char*)MemAlloc((unsigned int)size);
+        arena->size = arena->base ? size : 0;
+    }
+    arena->used = 0;
+    arena->demand = 0;
+}
+
+static void FreeRasterArena(RasterArena* arena)
+{
+    arena->demand = 0; // 只釋放 overflow，不再擴大
+    ResetRasterArena(arena);
+    MemFree(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
+
+// 可分離的最大值濾波 (先水平再垂直)：把點陣向外擴張 r 像素，結果為 (w + 2r) x (h + 2r)
+// 每個像素的成本與 r 無關；等同以正方形結構元素膨脹，保留原本的反鋸齒邊緣，
+// 但斜角方向的描邊約為直邊的 √2 倍粗 (圓形結構元素每像素要 O(r)，粗描邊改用 enableSDF 即為均勻粗細)
+// 結果與中間緩衝區都從點陣化暫存區配置
+static unsigned char* DilateGlyphBitmap(const unsigned char* src, int sw, int sh, int r, int* outW, int* outH)
+{
+    *outW = *outH = 0;
+    if (!src || sw <= 0 || sh <= 0) return NULL;
+
+    int w = sw + 2 * r, h = sh + 2 * r;
+    int line = ((sw > sh) ? sw : sh) + 4 * r;
+    unsigned char* tmp = (unsigned char*)RasterArenaAlloc((size_t)w * sh);
+    unsigned char* dst = (unsigned char*)RasterArenaAlloc((size_t)w * h);
+    unsigned char* scan = (unsigned char*)RasterArenaAlloc((size_t)line * 2);
+    if (!tmp || !dst || !scan) {
+        RasterArenaFree(tmp);
+        RasterArenaFree(dst);
+        RasterArenaFree(scan);
+        return NULL;
+    }
+
+    // 水平：輸出的 x 對應原圖 x - r，取原圖 [x - 2r, x] 的最大值
+    for (int y = 0; y < sh; y++) RunningMaxLine(&src[y * sw], sw, 1, r, &tmp[y * w], 1, scan, scan + line);
+
+    // 垂直：同樣的窗口套用在水平結果的每一直行上
+    for (int x = 0; x < w; x++) RunningMaxLine(&tmp[x], sh, w, r, &dst[x], w, scan, scan + line);
+
+    RasterArenaFree(scan);
+    RasterArenaFree(tmp);
+    *outW = w;
+    *outH = h;
+    return dst;
+}
+
+// 依字形鍵產生點陣 (SDF 變體產生距離場，描邊變體產生擴張後的點陣)；只讀取字型資料，背景執行緒也可呼叫
+// 點陣從本執行緒的點陣化暫存區配置，重置前有效；font、字形索引與 scale 由呼叫端在排入工作時取得 (字號可能在背景點陣化期間被回收)
+static unsigned char* RenderGlyphBitmap(unsigned int key, int font, int glyph, float scale, int* w, int* h)
+{
+    const stbtt_fontinfo* info = &g_ctx.fonts[font].info;
+    *w = *h = 0;
+    if (GLYPH_KEY_VARIANT(key) == GLYPH_VARIANT_SDF) {
+        return stbtt_GetGlyphSDF(info, scale, glyph, SDF_PADDING, SDF_ONEDGE, SDF_PIXEL_DIST_SCALE, w, h, NULL, NULL);
+    }
+
+    // 直接畫進暫存區 (stbtt_GetGlyphBitmap 會另外 malloc 一份點陣)
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(info, glyph, scale, scale, &x0, &y0, &x1, &y1);
+    int bw = x1 - x0, bh = y1 - y0;
+    if (bw <= 0 || bh <= 0) return NULL;
+    unsigned char* bmp = (unsigned char*)RasterArenaAlloc((size_t)bw * bh);
+    if (!bmp) return NULL;
+    stbtt_MakeGlyphBitmap(info, bmp, bw, bh, bw, scale, scale, glyph);
+
+    if (GLYPH_KEY_VARIANT(key) == GLYPH_VARIANT_OUTLINE) return DilateGlyphBitmap(bmp, bw, bh, GLYPH_KEY_RADIUS(key), w, h);
+    *w = bw;
+    *h = bh;
+    return bmp;
+}
+
+// 距離場由 stb_truetype 配置 (自訂 STBTT_malloc 時需交還)；其餘點陣隨暫存區重置回收
+static void FreeGlyphBitmap(unsigned int key, unsigned char* bmp)
+{
+    if (bmp && GLYPH_KEY_VARIANT(key) == GLYPH_VARIANT_SDF) stbtt_FreeSDF(bmp, NULL);
+}
+
+// 在主執行緒上同步點陣化 (使用上下文的暫存區，不逐字配置)
+static void RasterizeGlyph(AdvGlyph* g)
+{
+    int bw = 0, bh = 0;
+    const AdvStrike* strike = &g_ctx.strikes[GLYPH_KEY_STRIKE(g->key)];
+    STAT_ZONE_BEGIN(start, "AdvText Rasterize");
+    RasterArena* prevArena = BindRasterArena(&g_ctx.rasterArena);
+    unsigned char* bmp = RenderGlyphBitmap(g->key, strike->font, g->glyphIndex, strike->scale, &bw, &bh);
+    CommitGlyphBitmap(g, bmp, bw, bh);
+    FreeGlyphBitmap(g->key, bmp);
+    ResetRasterArena(&g_ctx.rasterArena);
+    BindRasterArena(prevArena);
+    STAT_ZONE_END(start, "AdvText Rasterize", rasterizeNs);
+    STAT_ADD(rasterizations, 1);
+}
+
+// 量測字形 (不點陣化、不佔快取)：填入度量資訊並回傳點陣大小；沒有字型資料可量測時回傳 false
+static bool MeasureGlyph(unsigned int key, AdvGlyph* out, int* w, int* h)
+{
+    const AdvStrike* strike = &g_ctx.strikes[GLYPH_KEY_STRIKE(key)];
+    const AdvFont* font = &g_ctx.fonts[strike->font];
+    if (!strike->active || !font->file.data) return false; // 只有烘焙快取，沒有字型可點陣化
+
+    int glyph = stbtt_FindGlyphIndex(&font->info, GLYPH_KEY_CODEPOINT(key));
+    bool sdf = (GLYPH_KEY_VARIANT(key) == GLYPH_VARIANT_SDF);
+    float scale = strike->scale;
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(&font->info, glyph, scale, scale, &x0, &y0, &x1, &y1);
+    if (x1 > x0 && y1 > y0) {
+        // 距離場四周多出 SDF_PADDING，描邊字形多出擴張半徑 (與 RenderGlyphBitmap 的輸出一致)
+        int pad = sdf ? SDF_PADDING : GLYPH_KEY_RADIUS(key);
+        x0 -= pad; y0 -= pad;
+        x1 += pad; y1 += pad;
+    }
+    int adv;
+    stbtt_GetGlyphHMetrics(&font->info, glyph, &adv, NULL);
+
+    memset(out, 0, sizeof(*out));
+    out->key = key;
+    out->bearingX = x0;
+    out->bearingY = y0;
+    out->advance = adv * scale;
+    out->glyphIndex = glyph;
+    *w = x1 - x0;
+    *h = y1 - y0;
+    return true;
+}
+
+// 新增字形：量測並配置插槽與圖集區域；deferred 時只填度量資訊，點陣交給背景執行緒
+static AdvGlyph* CreateGlyph(unsigned int key, bool deferred)
+{
+    // --- 步驟 1: 先量測字形大小 (尚不需點陣化) ---
+    int cp = GLYPH_KEY_CODEPOINT(key);
+    AdvGlyph metrics;
+    int w, h;
+    if (!MeasureGlyph(key, &metrics, &w, &h)) return NULL;
+    if (w + ATLAS_PADDING > ATLAS_SIZE || h + ATLAS_PADDING > ATLAS_SIZE) return NULL; // 比圖集還大，無法快取
+
+    // --- 步驟 2: 取得插槽與圖集區域 (優先回收冷字形) ---
+    int newIdx = -1, page = 0;
+    Rectangle cell = { 0 };
+    if (!AllocGlyphSpace(w, h, &newIdx, &page, &cell)) {
+        // 本幀用到的字形已塞滿快取或圖集：有幀邊界時只清空沒有本幀字形的圖集頁，
+        // 都有就放棄這個字 (已送出的繪製仍指向這些頁)；從未呼叫 BeginAdvTextFrame 時沿用整個清空 (Flush)
+        if (!g_ctx.framesTracked) FlushCache();
+        else if (!FlushUnpinnedPages()) {
+            TraceLog(LOG_WARNING, "AdvText: Glyph cache full with glyphs used this frame, U+%04X skipped (raise MAX_GLYPHS or MAX_ATLAS_PAGES)", cp);
+            return NULL;
+        }
+        if (!AllocGlyphSpace(w, h, &newIdx, &page, &cell)) return NULL;
+    }
+
+    // --- 步驟 3: 寫入快取結構 (插槽版本沿用，回收時已遞增) ---
+    AdvGlyph* g = &g_ctx.cache[newIdx];
+    metrics.serial = g->serial;
+    *g = metrics;
+    g->srcRec = (Rectangle){ cell.x, cell.y, 0, 0 };
+    g->cell = cell;
+    g->page = page;
+    g->lastUsed = g_ctx.frame;
+    g->active = true;
+    LruPushFront(newIdx);
+
+    // --- 步驟 4: 更新字形索引 ---
+    if (!GlyphIndexInsert(key, newIdx)) {
+        LruUnlink(newIdx);
+        g->active = false;
+        g_ctx.freeSlots[g_ctx.freeSlotCount++] = newIdx;
+        return NULL;
+    }
+
+    // --- 步驟 5: 使用 stb_truetype 產生字形 ---
+    STAT_ADD(cacheMisses, 1);
+    if (!deferred) RasterizeGlyph(g);
+
+    return g;
+}
+
+// [NEW] 取得字形 (核心優化：兩層直接索引 + LRU 回收)
+// 預載中的字形會直接回傳 (ready 為 false)，排版可用其度量資訊，繪製時先略過
+static AdvGlyph* GetGlyph(unsigned int key)
+{
+    int cacheIdx = GlyphIndexFind(key);
+    if (cacheIdx != -1) {
+        AdvGlyph* hit = &g_ctx.cache[cacheIdx];
+        TouchGlyph(hit); // 命中！標記本幀使用 (釘住)
+        STAT_ADD(cacheHits, 1);
+        return hit;
+    }
+
+    return CreateGlyph(key, false);
+}
+
+// -------------------------------------------------------------------------
+// 背景點陣化 (Prefetch)：工作執行緒只產生點陣，圖集與快取只由主執行緒修改
+// -------------------------------------------------------------------------
+
+#if defined(ADVTEXT_THREADS)
+// 在背景執行緒點陣化一個工作：暫存區在下一個工作前就會重置，結果複製一份交給主執行緒
+static void RenderRasterJob(RasterJob* job, RasterArena* arena)
+{
+    int bw = 0, bh = 0;
+    unsigned char* bmp = RenderGlyphBitmap(job->key, job->font, job->glyphIndex, job->scale, &bw, &bh);
+    job->bitmap = (bmp && bw > 0 && bh > 0) ? (unsigned char*)MemAlloc((unsigned int)(bw * bh)) : NULL;
+    if (job->bitmap) {
+        memcpy(job->bitmap, bmp, (size_t)bw * bh);
+        job->w = bw;
+        job->h = bh;
+    }
+    FreeGlyphBitmap(job->key, bmp);
+    ResetRasterArena(arena);
+}
+
+static void* RasterWorkerMain(void* arg)
+{
+    BindContext((AdvTextContext*)arg); // 點陣化讀取的是啟動此執行緒的上下文的字型
+    RasterWorkers* w = &g_ctx.workers;
+    RasterArena arena = { 0 };         // 每個工作執行緒各自的點陣化暫存區
+    BindRasterArena(&arena);
+
+    pthread_mutex_lock(&w->lock);
+    while (true) {
+        while (!w->quit && w->queueCount == 0) pthread_cond_wait(&w->wake, &w->lock);
+        if (w->quit) break;
+
+        RasterJob job = w->queue[w->queueHead];
+        w->queueHead = (w->queueHead + 1) % MAX_RASTER_JOBS;
+        w->queueCount--;
+        pthread_mutex_unlock(&w->lock);
+
+        // stbtt_fontinfo 在初始化後是唯讀的，可以多執行緒同時點陣化
+#if defined(ADVTEXT_ENABLE_STATS)
+        unsigned long long start = BeginStatZone("AdvText Rasterize");
+        RenderRasterJob(&job, &arena);
+        job.ns = EndStatZone("AdvText Rasterize", start);
+#else
+        RenderRasterJob(&job, &arena);
+#endif
+
+        pthread_mutex_lock(&w->lock);
+        w->done[(w->doneHead + w->doneCount) % MAX_RASTER_JOBS] = job;
+        w->doneCount++;
+    }
+    pthread_mutex_unlock(&w->lock);
+    BindRasterArena(NULL);
+    FreeRasterArena(&arena);
+    return NULL;
+}
+#endif
+
+// 啟動背景執行緒 (失敗時維持同步點陣化)
+static void StartRasterWorkers(void)
+{
+#if defined(ADVTEXT_THREADS)
+    RasterWorkers* w = &g_ctx.workers;
+    if (w->running) return;
+
+    w->queueHead = w->queueCount = 0;
+    w->doneHead = w->doneCount = 0;
+    w->inFlight = 0;
+    w->quit = false;
+    if (pthread_mutex_init(&w->lock, NULL) != 0) return;
+    if (pthread_cond_init(&w->wake, NULL) != 0) {
+        pthread_mutex_destroy(&w->lock);
+        return;
+    }
+
+    int started = 0;
+    for (int i = 0; i < RASTER_WORKER_COUNT; i++) {
+        if (pthread_create(&w->threads[i], NULL, RasterWorkerMain, g_current) != 0) break;
+        started++;
+    }
+    if (started < RASTER_WORKER_COUNT) {
+        pthread_mutex_lock(&w->lock);
+        w->quit = true;
+        pthread_cond_broadcast(&w->wake);
+        pthread_mutex_unlock(&w->lock);
+        for (int i = 0; i < started; i++) pthread_join(w->threads[i], NULL);
+        pthread_cond_destroy(&w->wake);
+        pthread_mutex_destroy(&w->lock);
+        TraceLog(LOG_WARNING, "AdvText: Failed to start raster workers, prefetch will rasterize synchronously");
+        return;
+    }
+
+    w->running = true;
+#endif
+}
+
+// 停止背景執行緒並丟棄尚未寫入圖集的結果
+static void StopRasterWorkers(void)
+{
+#if defined(ADVTEXT_THREADS)
+    RasterWorkers* w = &g_ctx.workers;
+    if (!w->running) return;
+
+    pthread_mutex_lock(&w->lock);
+    w->quit = true;
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+    for (int i = 0; i < RASTER_WORKER_COUNT; i++) pthread_join(w->threads[i], NULL);
+
+    for (int i = 0; i < w->doneCount; i++) {
+        MemFree(w->done[(w->doneHead + i) % MAX_RASTER_JOBS].bitmap);
+    }
+    w->queueCount = w->doneCount = w->inFlight = 0;
+
+    pthread_cond_destroy(&w->wake);
+    pthread_mutex_destroy(&w->lock);
+    w->running = false;
+#endif
+}
+
+// 排入背景點陣化，佇列滿或執行緒未啟動回傳 false
+static bool QueueRasterJob(AdvGlyph* g)
+{
+#if defined(ADVTEXT_THREADS)
+    RasterWorkers* w = &g_ctx.workers;
+    if (!w->running || w->inFlight >= MAX_RASTER_JOBS) return false;
+
+    pthread_mutex_lock(&w->lock);
+    const AdvStrike* strike = &g_ctx.strikes[GLYPH_KEY_STRIKE(g->key)];
+    w->queue[(w->queueHead + w->queueCount) % MAX_RASTER_JOBS] = (RasterJob){ .key = g->key, .slot = (int)(g - g_ctx.cache), .serial = g->serial, .font = strike->font,
+                                                                               .glyphIndex = g->glyphIndex, .scale = strike->scale };
+    w->queueCount++;
+    w->inFlight++;
+    pthread_cond_signal(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+    return true;
+#else
+    (void)g;
+    return false;
+#endif
+}
+
+// 把背景完成的點陣寫入圖集 (主執行緒呼叫)；字形期間被回收或清空時丟棄結果
+static void ProcessRasterResults(void)
+{
+#if defined(ADVTEXT_THREADS)
+    RasterWorkers* w = &g_ctx.workers;
+    if (!w->running || w->inFlight == 0) return;
+
+    pthread_mutex_lock(&w->lock);
+    while (w->doneCount > 0) {
+        RasterJob job = w->done[w->doneHead];
+        w->doneHead = (w->doneHead + 1) % MAX_RASTER_JOBS;
+        w->doneCount--;
+        w->inFlight--;
+        STAT_ADD(rasterizations, 1);
+        STAT_ADD(rasterizeNs, job.ns);
+
+        AdvGlyph* g = &g_ctx.cache[job.slot];
+        if (g->active && !g->ready && g->serial == job.serial) {
+            CommitGlyphBitmap(g, job.bitmap, job.w, job.h);
+        }
+        MemFree(job.bitmap);
+    }
+    pthread_mutex_unlock(&w->lock);
+#endif
+}
+
+// 字形是否正在背景點陣化 (不會新增字形)
+static bool IsGlyphPending(unsigned int key)
+{
+    int cacheIdx = GlyphIndexFind(key);
+    return (cacheIdx != -1 && !g_ctx.cache[cacheIdx].ready);
+}
+
+// -------------------------------------------------------------------------
+// 多字型：[font=名稱] 標籤與缺字時的備援鏈
+// -------------------------------------------------------------------------
+
+// 依名稱找字型 (不分大小寫)，找不到回傳主字型
+static int FindFontByName(const char* name, int len)
+{
+    for (int i = 0; i < g_ctx.fontCount; i++) {
+        const char* fontName = g_ctx.fonts[i].name;
+        if ((int)strlen(fontName) == len && SafeStrNCaseCmp(fontName, name, len) == 0) return i;
+    }
+    return 0;
+}
+
+// 字型是否有這個字 (只有烘焙快取的主字型以快取內容為準)
+static bool FontHasGlyph(int font, int cp)
+{
+    const AdvFont* f = &g_ctx.fonts[font];
+    if (!f->file.data) return GlyphIndexFind(MAKE_GLYPH_KEY(font, cp, GLYPH_VARIANT_BITMAP)) != -1;
+    return stbtt_FindGlyphIndex(&f->info, cp) != 0;
+}
+
+// 只查詢 fontMemo，不修改任何狀態 (讀鎖下可用)；尚未解析過回傳 -1
+static int FindGlyphFont(int font, int cp)
+{
+    if (font < 0 || font >= g_ctx.fontCount) font = 0;
+    if (g_ctx.fontCount <= 1) return font;
+
+    unsigned int key = MAKE_GLYPH_KEY(font, cp, 0);
+    for (int h = key % FONT_MEMO_SIZE; g_ctx.fontMemo[h].key != 0; h = (h + 1) % FONT_MEMO_SIZE) {
+        if (g_ctx.fontMemo[h].key == key) return g_ctx.fontMemo[h].font;
+    }
+    return -1;
+}
+
+// 決定碼點要用哪個字型繪製：指定的字型 -> 備援鏈 (依註冊順序)，都沒有時沿用指定的字型 (顯示缺字框)
+// 結果記在 fontMemo 中，stbtt_FindGlyphIndex 每個 (字型, 碼點) 只查一次
+static int ResolveGlyphFont(int font, int cp)
+{
+    int memo = FindGlyphFont(font, cp);
+    if (memo >= 0) return memo;
+
+    if (font < 0 || font >= g_ctx.fontCount) font = 0;
+    unsigned int key = MAKE_GLYPH_KEY(font, cp, 0);
+    int h = key % FONT_MEMO_SIZE;
+    while (g_ctx.fontMemo[h].key != 0) h = (h + 1) % FONT_MEMO_SIZE;
+
+    int resolved = font;
+    if (!FontHasGlyph(font, cp)) {
+        for (int i = 0; i < g_ctx.fontCount; i++) {
+            if (i == font || !g_ctx.fonts[i].fallback) continue;
+            if (FontHasGlyph(i, cp)) { resolved = i; break; }
+        }
+    }
+
+    // 表快滿時整個清空 (線性探測在高負載下會變慢)
+    if (g_ctx.fontMemoCount >= FONT_MEMO_SIZE * 3 / 4) {
+        memset(g_ctx.fontMemo, 0, sizeof(g_ctx.fontMemo));
+        g_ctx.fontMemoCount = 0;
+        h = key % FONT_MEMO_SIZE;
+    }
+    g_ctx.fontMemo[h] = (FontMemoEntry){ key, resolved };
+    g_ctx.fontMemoCount++;
+    return resolved;
+}
+
+// 只查詢 kernMemo (讀鎖下可用)；查到或不需要字距時回傳 true
+static bool FindKernAdvance(int font, int left, int right, int* kern)
+{
+    *kern = 0;
+    if (!g_ctx.fonts[font].hasKerning || left <= 0 || right <= 0) return true;
+
+    unsigned int pair = ((unsigned int)left << 16) | (unsigned int)(right & 0xFFFF);
+    int h = (int)(((pair * 2654435761u) ^ (unsigned int)font) % KERN_MEMO_SIZE);
+    while (g_ctx.kernMemo[h].pair != 0) {
+        if (g_ctx.kernMemo[h].pair == pair && g_ctx.kernMemo[h].font == font) {
+            *kern = g_ctx.kernMemo[h].kern;
+            return true;
+        }
+        h = (h + 1) % KERN_MEMO_SIZE;
+    }
+    return false;
+}
+
+// 同一字型相鄰兩個字形的字距調整 (未縮放的字型單位)
+// 結果記在 kernMemo 中，stbtt 的 kern/GPOS 搜尋每對只做一次
+static int GetKernAdvance(int font, int left, int right)
+{
+    int kern = 0;
+    if (FindKernAdvance(font, left, right, &kern)) return kern;
+
+    unsigned int pair = ((unsigned int)left << 16) | (unsigned int)(right & 0xFFFF);
+    int h = (int)(((pair * 2654435761u) ^ (unsigned int)font) % KERN_MEMO_SIZE);
+    while (g_ctx.kernMemo[h].pair != 0) h = (h + 1) % KERN_MEMO_SIZE;
+
+    kern = stbtt_GetGlyphKernAdvance(&g_ctx.fonts[font].info, left, right);
+
+    // 表快滿時整個清空 (與 fontMemo 相同)
+    if (g_ctx.kernMemoCount >= KERN_MEMO_SIZE * 3 / 4) {
+        memset(g_ctx.kernMemo, 0, sizeof(g_ctx.kernMemo));
+        g_ctx.kernMemoCount = 0;
+        h = (int)(((pair * 2654435761u) ^ (unsigned int)font) % KERN_MEMO_SIZE);
+    }
+    g_ctx.kernMemo[h] = (KernMemoEntry){ pair, (short)font, (short)kern };
+    g_ctx.kernMemoCount++;
+    return kern;
+}
+
+// 只查詢已建立的 (字型, 字號) 組合 (讀鎖下可用，不更新 lastUsed)；沒有時回傳 -1
+static int FindStrike(int font, int size)
+{
+    for (int i = 0; i < MAX_STRIKES; i++) {
+        const AdvStrike* st = &g_ctx.strikes[i];
+        if (st->active && st->font == font && st->size == size) return i;
+    }
+    return g_ctx.fonts[font].file.data ? -1 : 0; // 只有烘焙快取時沿用烘焙的字號 (與 GetStrike 相同)
+}
+
+// 建立或取得 (字型, 字號) 組合，回傳其編號 (字形鍵中的 strike)
+// 表滿時回收最久未用的組合 (主字型的初始字號與本幀用過的組合除外)；其字形保留圖集區域，讓 LRU 優先沿用
+static int GetStrike(int font, int size)
+{
+    int freeIdx = -1, lru = -1;
+    for (int i = 0; i < MAX_STRIKES; i++) {
+        AdvStrike* st = &g_ctx.strikes[i];
+        if (!st->active) {
+            if (freeIdx == -1) freeIdx = i;
+            continue;
+        }
+        if (st->font == font && st->size == size) {
+            st->lastUsed = g_ctx.frame;
+            return i;
+        }
+        // 本幀用過的組合其字形可能已送出繪製，回收會讓圖集區域在同一幀被新字形覆寫
+        if (g_ctx.framesTracked && st->lastUsed == g_ctx.frame) continue;
+        if (i > 0 && (lru == -1 || (int)(st->lastUsed - g_ctx.strikes[lru].lastUsed) < 0)) lru = i;
+    }
+
+    // 沒有字型資料 (只有烘焙快取) 無法產生新字號，沿用烘焙的字號
+    const AdvFont* f = &g_ctx.fonts[font];
+    if (!f->file.data) return 0;
+
+    int idx = freeIdx;
+    if (idx == -1) {
+        // 一幀內用到超過 MAX_STRIKES 種字號：這一幀先以主字型的初始字號代替 (下一幀再回收)
+        if (lru == -1) {
+            TraceLog(LOG_WARNING, "AdvText: Font size table full with sizes used this frame, size %d of font %d drawn at size %d (raise MAX_STRIKES)",
+                     size, font, g_ctx.strikes[0].size);
+            return 0;
+        }
+        idx = lru;
+        for (int i = 0; i < MAX_GLYPHS; i++) {
+            const AdvGlyph* g = &g_ctx.cache[i];
+            if (g->active && g->key != RETIRED_GLYPH_KEY && GLYPH_KEY_STRIKE(g->key) == idx) RetireGlyph(i);
+        }
+        TraceLog(LOG_INFO, "AdvText: Font size table full (MAX_STRIKES %d), size %d of font %d recycled",
+                 MAX_STRIKES, g_ctx.strikes[idx].size, g_ctx.strikes[idx].font);
+    }
+
+    AdvStrike* st = &g_ctx.strikes[idx];
+    st->font = font;
+    st->size = size;
+    st->scale = stbtt_ScaleForPixelHeight(&f->info, (float)size);
+    st->ascent = (int)(f->ascent * st->scale);
+    st->descent = (int)(f->descent * st->scale);
+    st->lineGap = (int)(f->lineGap * st->scale);
+    st->lastUsed = g_ctx.frame;
+    st->epoch = ++g_ctx.strikeEpoch;
+    st->active = true;
+    return idx;
+}
+
+// -------------------------------------------------------------------------
+// 富文本解析 (Tokenizer)：單趟把文字轉成片段陣列，排版、預載與打字機共用
+// -------------------------------------------------------------------------
+
+// FNV-1a (ASCII 不分大小寫)
+static unsigned int HashTagName(const char* name, int len)
+{
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)name[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+static bool InsertDictEntry(RichDictEntry* table, int bits, unsigned int seed, RichDictEntry entry)
+{
+    entry.len = (int)strlen(entry.name);
+    RichDictEntry* slot = &table[(HashTagName(entry.name, entry.len) * seed) >> (32 - bits)];
+    if (slot->name) {
+        TraceLog(LOG_WARNING, "AdvText: Tag dictionary collision between '%s' and '%s', reseed the hash", slot->name, entry.name);
+        return false;
+    }
+    *slot = entry;
+    return true;
+}
+
+// 完美雜湊查表：一次雜湊、一次比對
+static const RichDictEntry* LookupDictEntry(const RichDictEntry* table, int bits, unsigned int seed, const char* name, int len)
+{
+    const RichDictEntry* e = &table[(HashTagName(name, len) * seed) >> (32 - bits)];
+    if (!e->name || e->len != len || SafeStrNCaseCmp(e->name, name, len) != 0) return NULL;
+    return e;
+}
+
+// 建立標籤與顏色字典 (顏色名稱與 raylib 的預設色一致)
+static void BuildTagDictionary(void)
+{
+    const RichDictEntry tags[] = {
+        { "color", 0, RICH_TAG_COLOR, BLANK }, { "/color", 0, RICH_TAG_COLOR_END, BLANK },
+        { "font", 0, RICH_TAG_FONT, BLANK }, { "/font", 0, RICH_TAG_FONT_END, BLANK },
+        { "pause", 0, RICH_TAG_PAUSE, BLANK },
+    };
+    const RichDictEntry colors[] = {
+        { "lightgray", 0, RICH_TAG_NONE, LIGHTGRAY }, { "gray", 0, RICH_TAG_NONE, GRAY }, { "darkgray", 0, RICH_TAG_NONE, DARKGRAY },
+        { "yellow", 0, RICH_TAG_NONE, YELLOW }, { "gold", 0, RICH_TAG_NONE, GOLD }, { "orange", 0, RICH_TAG_NONE, ORANGE },
+        { "pink", 0, RICH_TAG_NONE, PINK }, { "red", 0, RICH_TAG_NONE, RED }, { "maroon", 0, RICH_TAG_NONE, MAROON },
+        { "green", 0, RICH_TAG_NONE, GREEN }, { "lime", 0, RICH_TAG_NONE, LIME }, { "darkgreen", 0, RICH_TAG_NONE, DARKGREEN },
+        { "skyblue", 0, RICH_TAG_NONE, SKYBLUE }, { "blue", 0, RICH_TAG_NONE, BLUE }, { "darkblue", 0, RICH_TAG_NONE, DARKBLUE },
+        { "purple", 0, RICH_TAG_NONE, PURPLE }, { "violet", 0, RICH_TAG_NONE, VIOLET }, { "darkpurple", 0, RICH_TAG_NONE, DARKPURPLE },
+        { "beige", 0, RICH_TAG_NONE, BEIGE }, { "brown", 0, RICH_TAG_NONE, BROWN }, { "darkbrown", 0, RICH_TAG_NONE, DARKBROWN },
+        { "white", 0, RICH_TAG_NONE, WHITE }, { "black", 0, RICH_TAG_NONE, BLACK }, { "blank", 0, RICH_TAG_NONE, BLANK },
+        { "magenta", 0, RICH_TAG_NONE, MAGENTA }, { "raywhite", 0, RICH_TAG_NONE, RAYWHITE },
+    };
+
+    memset(g_ctx.tagDict, 0, sizeof(g_ctx.tagDict));
+    memset(g_ctx.colorDict, 0, sizeof(g_ctx.colorDict));
+    for (int i = 0; i < (int)(sizeof(tags) / sizeof(tags[0])); i++) InsertDictEntry(g_ctx.tagDict, TAG_HASH_BITS, TAG_HASH_SEED, tags[i]);
+    for (int i = 0; i < (int)(sizeof(colors) / sizeof(colors[0])); i++) InsertDictEntry(g_ctx.colorDict, COLOR_HASH_BITS, COLOR_HASH_SEED, colors[i]);
+    g_ctx.dictReady = true;
+}
+
+// 解析 RRGGBB 或 RRGGBBAA
+static bool ParseHexColor(const char* hex, int len, Color* out)
+{
+    if (len != 6 && len != 8) return false;
+    unsigned int v = 0;
+    for (int i = 0; i < len; i++) {
+        char c = hex[i];
+        int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (d < 0) return false;
+        v = (v << 4) | (unsigned int)d;
+    }
+    if (len == 6) v = (v << 8) | 0xFF;
+    *out = (Color){ (unsigned char)(v >> 24), (unsigned char)(v >> 16), (unsigned char)(v >> 8), (unsigned char)v };
+    return true;
+}
+
+// 顏色標籤的值：名稱或 #RRGGBB[AA]，無法辨識時為 RAYWHITE (與舊版相同)
+static Color ParseTagColor(const char* value, int len)
+{
+    Color c = RAYWHITE;
+    if (len > 0 && value[0] == '#') {
+        ParseHexColor(value + 1, len - 1, &c);
+        return c;
+    }
+    const RichDictEntry* e = LookupDictEntry(g_ctx.colorDict, COLOR_HASH_BITS, COLOR_HASH_SEED, value, len);
+    return e ? e->color : c;
+}
+
+// 解析 text[idx] 開始的標籤：回傳標籤長度 (不是可辨識的標籤時回傳 0，當作一般文字)
+static int ParseRichTag(const char* text, int idx, RichTagKind* kind, const char** value, int* valueLen)
+{
+    const char* p = &text[idx + 1];
+    const char* eq = NULL;
+    int len = 1;
+    while (p[0] && p[0] != ']' && p[0] != '\n' && p[0] != '[') {
+        if (p[0] == '=' && !eq) eq = p;
+        p++;
+        if (++len >= MAX_TAG_LEN) return 0;
+    }
+    if (p[0] != ']') return 0;
+
+    const char* name = &text[idx + 1];
+    int nameLen = (int)((eq ? eq : p) - name);
+    const RichDictEntry* e = LookupDictEntry(g_ctx.tagDict, TAG_HASH_BITS, TAG_HASH_SEED, name, nameLen);
+    if (!e) return 0;
+
+    // 開始標籤需要值，結束標籤不能有值
+    bool needsValue = (e->kind == RICH_TAG_COLOR || e->kind == RICH_TAG_FONT || e->kind == RICH_TAG_PAUSE);
+    if (needsValue != (eq != NULL)) return 0;
+
+    *kind = e->kind;
+    *value = eq ? eq + 1 : p;
+    *valueLen = (int)(p - *value);
+    return (int)(p - &text[idx]) + 1;
+}
+
+static bool PushTextRun(TextRunList* list, int start, int end, Color color, int font, float pause)
+{
+    if (!ReserveArray((void**)&list->runs, &list->capacity, list->count + 1, sizeof(TextRun))) return false;
+    list->runs[list->count++] = (TextRun){ start, end, color, font, pause };
+    return true;
+}
+
+// 單趟解析：標籤改變樣式堆疊，兩個標籤之間的文字成為一個片段
+// 顏色與字型各有獨立的堆疊，[/color] 與 [/font] 回到外層的設定 (交錯的結束標籤也不會互相干擾)
+static bool TokenizeRichText(TextRunList* list, const char* text, Color baseColor)
+{
+    if (!g_ctx.dictReady) BuildTagDictionary();
+    list->count = 0;
+
+    Color colorStack[STYLE_STACK_DEPTH];
+    int fontStack[STYLE_STACK_DEPTH];
+    int colorDepth = 0, fontDepth = 0;
+    Color color = baseColor;
+    int font = 0;
+    float pause = 0.0f;
+
+    int runStart = 0;
+    const char* bracket = strchr(text, '[');
+    while (bracket) {
+        int idx = (int)(bracket - text);
+        RichTagKind kind = RICH_TAG_NONE;
+        const char* value = NULL;
+        int valueLen = 0;
+        int tagLen = ParseRichTag(text, idx, &kind, &value, &valueLen);
+        if (tagLen == 0) {
+            bracket = strchr(bracket + 1, '[');
+            continue;
+        }
+
+        // 標籤前的文字以目前樣式成為一個片段 (樣式連續改變時不產生空片段)
+        if (idx > runStart) {
+            if (!PushTextRun(list, runStart, idx, color, font, pause)) return false;
+            pause = 0.0f;
+        }
+
+        switch (kind) {
+            case RICH_TAG_COLOR:
+                if (colorDepth < STYLE_STACK_DEPTH) colorStack[colorDepth++] = color;
+                color = ParseTagColor(value, valueLen);
+                break;
+            case RICH_TAG_COLOR_END:
+                color = (colorDepth > 0) ? colorStack[--colorDepth] : baseColor;
+                break;
+            case RICH_TAG_FONT:
+                if (fontDepth < STYLE_STACK_DEPTH) fontStack[fontDepth++] = font;
+                font = FindFontByName(value, valueLen);
+                break;
+            case RICH_TAG_FONT_END:
+                font = (fontDepth > 0) ? fontStack[--fontDepth] : 0;
+                break;
+            case RICH_TAG_PAUSE: {
+                float seconds = strtof(value, NULL);
+                if (seconds > 0.0f) pause += seconds;
+            } break;
+            default: break;
+        }
+
+        runStart = idx + tagLen;
+        bracket = strchr(&text[runStart], '[');
+    }
+
+    int end = runStart + (int)strlen(&text[runStart]);
+    if (end > runStart || pause > 0.0f) return PushTextRun(list, runStart, end, color, font, pause);
+    return true;
+}
+
+// 取得片段中的下一個碼點 (跨片段前進)：*idx 移到碼點開頭，回傳所屬片段；文字結束回傳 NULL
+// 呼叫端處理完後自行 *idx += *bytes
+static const TextRun* PeekRunCodepoint(const TextRunList* list, const char* text, int* run, int* idx, int* cp, int* bytes)
+{
+    while (*run < list->count) {
+        const TextRun* r = &list->runs[*run];
+        if (*idx < r->start) *idx = r->start;
+        if (*idx < r->end) {
+            *cp = GetCodepointNext(&text[*idx], bytes);
+            return r;
+        }
+        (*run)++;
+    }
+    return NULL;
+}
+
+// 預載與進度查詢共用：回傳下一個可見碼點在字號 size、變體 variant 下的字形鍵
+// 文字結束回傳 false；換行的 *cp 為 '\n'
+static bool NextTextGlyph(const TextRunList* list, const char* text, int* run, int* idx, int* cp, unsigned int* key, int size, int variant)
+{
+    int bytes = 0;
+    const TextRun* r = PeekRunCodepoint(list, text, run, idx, cp, &bytes);
+    if (!r) return false;
+    *idx += bytes;
+    *key = MAKE_GLYPH_KEY(GetStrike(ResolveGlyphFont(r->font, *cp), size), *cp, variant);
+    return true;
+}
+
+// 樣式 (已由 NormalizeStyle 填入字號) 對應的字形：strike 字號、變體與點陣描邊半徑 (0 為不描邊)
+// 排版與預載共用，預載的字形鍵與之後繪製時查詢的一致
+static void GetStyleGlyphParams(const AdvTextStyle* style, int* size, int* variant, int* outlineRadius)
+{
+    int px = (int)(style->fontSize + 0.5f);
+    *size = style->enableSDF ? SDF_BASE_SIZE : (px < 1) ? 1 : px;
+    *variant = style->enableSDF ? GLYPH_VARIANT_SDF : GLYPH_VARIANT_BITMAP;
+    *outlineRadius = 0;
+    if (style->enableOutline && !style->enableSDF) {
+        int radius = (int)(style->outlineThickness + 0.5f);
+        *outlineRadius = (radius < 1) ? 1 : (radius > MAX_OUTLINE_RADIUS) ? MAX_OUTLINE_RADIUS : radius;
+    }
+}
+
+// -------------------------------------------------------------------------
+// SDF 著色器：在片段著色器中一次合成陰影、描邊與本體
+// -------------------------------------------------------------------------
+
+// OpenGL ES 2.0 / WebGL 使用 GLSL 100，桌面使用 GLSL 330 (頂點著色器沿用 raylib 預設)
+#if defined(GRAPHICS_API_OPENGL_ES2) || defined(PLATFORM_WEB) || defined(PLATFORM_ANDROID)
+    #define SDF_SHADER_HEADER \
+        "#version 100\n" \
+        "precision mediump float;\n" \
+        "#define IN varying\n" \
+        "#define TEXTURE texture2D\n" \
+        "#define FINAL_COLOR gl_FragColor\n"
+#else
+    #define SDF_SHADER_HEADER \
+        "#version 330\n" \
+        "#define IN in\n" \
+        "#define TEXTURE texture\n" \
+        "out vec4 finalColor;\n" \
+        "#define FINAL_COLOR finalColor\n"
+#endif
+
+// 距離值存在 Alpha (0.5 為字形邊緣)；各層以 "over" 疊加：陰影 -> 描邊 -> 本體
+static const char* sdfFragmentShader = SDF_SHADER_HEADER
+    "IN vec2 fragTexCoord;\n"
+    "IN vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "uniform vec4 outlineColor;\n"
+    "uniform float outlineWidth;\n"
+    "uniform vec4 shadowColor;\n"
+    "uniform vec2 shadowOffset;\n"
+    "uniform float smoothing;\n"
+    "void main()\n"
+    "{\n"
+    "    float dist = TEXTURE(texture0, fragTexCoord).a;\n"
+    "    float edge = 0.5 - outlineWidth;\n"
+    "    float fillA = smoothstep(0.5 - smoothing, 0.5 + smoothing, dist);\n"
+    "    float outlineA = smoothstep(edge - smoothing, edge + smoothing, dist)*outlineColor.a;\n"
+    "    float shadowDist = TEXTURE(texture0, fragTexCoord - shadowOffset).a;\n"
+    "    float shadowA = smoothstep(edge - smoothing, edge + smoothing, shadowDist)*shadowColor.a;\n"
+    "    vec4 fill = fragColor*colDiffuse;\n"
+    "    fillA *= fill.a;\n"
+    "    vec4 color = vec4(shadowColor.rgb*shadowA, shadowA);\n"
+    "    color = vec4(outlineColor.rgb*outlineA, outlineA) + color*(1.0 - outlineA);\n"
+    "    color = vec4(fill.rgb*fillA, fillA) + color*(1.0 - fillA);\n"
+    "    if (color.a > 0.0) color.rgb /= color.a;\n"
+    "    FINAL_COLOR = color;\n"
+    "}\n";
+
+// 第一次使用 SDF 模式時載入著色器 (需要 GPU，烘焙與純排版不會用到)
+static bool LoadSDFShader(void)
+{
+    SDFShader* sdf = &g_ctx.sdf;
+    if (sdf->loaded) return (sdf->shader.id > 0);
+
+    sdf->shader = LoadShaderFromMemory(NULL, sdfFragmentShader);
+    sdf->outlineColorLoc = GetShaderLocation(sdf->shader, "outlineColor");
+    sdf->outlineWidthLoc = GetShaderLocation(sdf->shader, "outlineWidth");
+    sdf->shadowColorLoc = GetShaderLocation(sdf->shader, "shadowColor");
+    sdf->shadowOffsetLoc = GetShaderLocation(sdf->shader, "shadowOffset");
+    sdf->smoothingLoc = GetShaderLocation(sdf->shader, "smoothing");
+    sdf->loaded = true;
+    return (sdf->shader.id > 0);
+}
+
+static void UnloadSDFShader(void)
+{
+    if (g_ctx.sdf.loaded) UnloadShader(g_ctx.sdf.shader);
+    memset(&g_ctx.sdf, 0, sizeof(g_ctx.sdf));
+}
+
+// -------------------------------------------------------------------------
+// 斷行規則：UAX #14 的簡化子集加上中日文避頭尾 (禁則)，只看相鄰兩字決定能否斷行
+// -------------------------------------------------------------------------
+
+enum {
+    BREAK_CLASS_AL,         // 字母與數字 (西文單字內不斷行)
+    BREAK_CLASS_ID,         // 漢字、假名、諺文、全形字與表情符號 (前後皆可斷行)
+    BREAK_CLASS_SP,         // 空白 (之後可斷行)
+    BREAK_CLASS_BA,         // 連字號 (之後可斷行)
+    BREAK_CLASS_ZW,         // 零寬空白 (之後可斷行)
+    BREAK_CLASS_OP,         // 開括號與開引號 (不可置於行尾)
+    BREAK_CLASS_CL,         // 閉括號、閉引號、頓號與句號 (不可置於行首)
+    BREAK_CLASS_NS,         // 小假名、長音符、疊字符與全形冒號 (不可置於行首)
+    BREAK_CLASS_EX,         // 驚嘆號與問號 (不可置於行首)
+    BREAK_CLASS_IS,         // 西文逗號、句號與冒號 (不可置於行首，數字中不斷行)
+    BREAK_CLASS_IN,         // 刪節號 (不可置於行首)
+    BREAK_CLASS_GL,         // 不斷行空白與字詞連接符 (前後皆不可斷行)
+    BREAK_CLASS_CM          // 結合用字元與變體選擇符 (附著於前一字，視同前一字的類別)
+};
+
+// 不可在其前斷行的類別
+#define BREAK_NEVER_BEFORE ((1u << BREAK_CLASS_SP) | (1u << BREAK_CLASS_BA) | (1u << BREAK_CLASS_ZW) | \
+                            (1u << BREAK_CLASS_CL) | (1u << BREAK_CLASS_NS) | (1u << BREAK_CLASS_EX) | \
+                            (1u << BREAK_CLASS_IS) | (1u << BREAK_CLASS_IN) | (1u << BREAK_CLASS_GL) | (1u << BREAK_CLASS_CM))
+
+// 碼點的斷行類別
+static int GetBreakClass(int cp)
+{
+    // 常見情況先判斷：英文字母、數字與常用漢字
+    if ((cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z') || (cp >= '0' && cp <= '9')) return BREAK_CLASS_AL;
+    if (cp >= 0x4E00 && cp <= 0x9FFF) return BREAK_CLASS_ID;
+
+    switch (cp) {
+        case ' ': case '\t': case 0x3000:
+            return BREAK_CLASS_SP;
+        case '-': case 0x00AD: case 0x2010: case 0x2013:
+            return BREAK_CLASS_BA;
+        case 0x200B:
+            return BREAK_CLASS_ZW;
+        case 0x00A0: case 0x2007: case 0x202F: case 0x2060: case 0xFEFF:
+            return BREAK_CLASS_GL;
+        case '(': case '[': case '{': case 0x2018: case 0x201C:
+        case 0x3008: case 0x300A: case 0x300C: case 0x300E: case 0x3010: case 0x3014: case 0x3016: case 0x3018:
+        case 0x301A: case 0x301D: case 0xFF08: case 0xFF3B: case 0xFF5B: case 0xFF5F: case 0xFF62:
+            return BREAK_CLASS_OP;
+        case ')': case ']': case '}': case 0x2019: case 0x201D: case 0x3001: case 0x3002:
+        case 0x3009: case 0x300B: case 0x300D: case 0x300F: case 0x3011: case 0x3015: case 0x3017: case 0x3019:
+        case 0x301B: case 0x301E: case 0x301F: case 0xFF09: case 0xFF0C: case 0xFF0E: case 0xFF3D: case 0xFF5D:
+        case 0xFF60: case 0xFF61: case 0xFF63: case 0xFF64:
+            return BREAK_CLASS_CL;
+        case 0x3005: case 0x301C: case 0x303B: case 0x309D: case 0x309E: case 0x30A0: case 0x30FB: case 0x30FC:
+        case 0x30FD: case 0x30FE: case 0xFF1A: case 0xFF1B: case 0xFF65: case 0xFF70:
+        case 0x3063: case 0x3083: case 0x3085: case 0x3087: case 0x308E: case 0x3095: case 0x3096:
+        case 0x30C3: case 0x30E3: case 0x30E5: case 0x30E7: case 0x30EE: case 0x30F5: case 0x30F6:
+            return BREAK_CLASS_NS;
+        case '!': case '?': case 0x203C: case 0x2047: case 0x2048: case 0x2049: case 0xFF01: case 0xFF1F:
+            return BREAK_CLASS_EX;
+        case ',': case '.': case ':': case ';':
+            return BREAK_CLASS_IS;
+        case 0x2025: case 0x2026:
+            return BREAK_CLASS_IN;
+        case 0x200D:
+            return BREAK_CLASS_CM;
+        default:
+            break;
+    }
+
+    // 小寫的ぁぃぅぇぉ與ァィゥェォ (奇數碼點) 及片假名音標擴充
+    if ((cp >= 0x3041 && cp <= 0x3049 && (cp & 1)) || (cp >= 0x30A1 && cp <= 0x30A9 && (cp & 1)) ||
+        (cp >= 0x31F0 && cp <= 0x31FF)) return BREAK_CLASS_NS;
+
+    if ((cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x1AB0 && cp <= 0x1AFF) || (cp >= 0x1DC0 && cp <= 0x1DFF) ||
+        (cp >= 0x20D0 && cp <= 0x20FF) || (cp >= 0x3099 && cp <= 0x309A) || (cp >= 0xFE00 && cp <= 0xFE0F) ||
+        (cp >= 0xFE20 && cp <= 0xFE2F) || (cp >= 0x1F3FB && cp <= 0x1F3FF) || (cp >= 0xE0100 && cp <= 0xE01EF)) {
+        return BREAK_CLASS_CM;
+    }
+
+    if ((cp >= 0x1100 && cp <= 0x115F) || (cp >= 0x2E80 && cp <= 0x9FFF) || (cp >= 0xA960 && cp <= 0xA97F) ||
+        (cp >= 0xAC00 && cp <= 0xD7AF) || (cp >= 0xF900 && cp <= 0xFAFF) || (cp >= 0xFE30 && cp <= 0xFE4F) ||
+        (cp >= 0xFF00 && cp <= 0xFFEF) || (cp >= 0x1F000 && cp <= 0x1FAFF) || (cp >= 0x20000 && cp <= 0x3FFFD)) {
+        return BREAK_CLASS_ID;
+    }
+    return BREAK_CLASS_AL;
+}
+
+// 能否在類別 prev 與 cur 的兩字之間斷行 (prev 為前一個非結合字元的類別)
+static bool CanBreakBetween(int prev, int cur)
+{
+    if (BREAK_NEVER_BEFORE & (1u << cur)) return false;
+    if (prev == BREAK_CLASS_OP || prev == BREAK_CLASS_GL) return false;
+    // 西文單字、函式呼叫 f(x) 與數字 3.14 內不斷行
+    if (prev == BREAK_CLASS_AL && (cur == BREAK_CLASS_AL || cur == BREAK_CLASS_OP)) return false;
+    if (prev == BREAK_CLASS_IS && cur == BREAK_CLASS_AL) return false;
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// 排版引擎 (Layout)：解析標籤、量測、換行與對齊只做一次
+// DrawRichTextStyled 與 AdvTextLayout 共用同一份排版結果
+// -------------------------------------------------------------------------
+
+// 樣式預設值保護
+static AdvTextStyle NormalizeStyle(AdvTextStyle style)
+{
+    if (style.bgPaddingX == 0) style.bgPaddingX = 8.0f;
+    if (style.bgPaddingY == 0) style.bgPaddingY = 6.0f;
+    if (style.outlineThickness == 0) style.outlineThickness = 1.0f;
+    if (style.lineSpacing == 0) style.lineSpacing = 1.0f;
+    if (style.fontSize <= 0) style.fontSize = (float)g_ctx.fontSize;
+    if (!g_ctx.fonts[0].file.data) style.enableSDF = false; // 只有烘焙快取時沒有字型可產生距離場
+    return style;
+}
+
+// 對齊偏移：行的左緣相對於繪製原點的位置
+static float GetAlignOffset(const AdvTextStyle* style, float lineW)
+{
+    if (style->align == TEXT_ALIGN_CENTER) return -lineW / 2.0f;
+    if (style->align == TEXT_ALIGN_RIGHT) return -lineW;
+    return 0.0f;
+}
+
+// 結束目前行：套用對齊偏移並記錄行背景
+static void EndLayoutLine(AdvTextLayout* layout, float lineW, float lineHeight)
+{
+    const AdvTextStyle* style = &layout->style;
+    AdvLayoutLine* line = &layout->lines[layout->lineCount - 1];
+
+    float offX = GetAlignOffset(style, lineW);
+
+    for (int i = line->firstGlyph; i < line->firstGlyph + line->glyphCount; i++) {
+        layout->glyphs[i].offset.x += offX;
+    }
+
+    line->width = lineW;
+    line->bgRec = (Rectangle){ offX - style->bgPaddingX, line->y - style->bgPaddingY,
+                               lineW + style->bgPaddingX * 2, lineHeight + style->bgPaddingY * 2 };
+
+    if (lineW > layout->width) layout->width = lineW;
+}
+
+// 開始新的一行 (記錄行首位置，長文件從這裡接續排版)
+static bool BeginLayoutLine(AdvTextLayout* layout, float y, int firstGlyph, int run, int textOffset)
+{
+    if (!ReserveArray((void**)&layout->lines, &layout->lineCapacity, layout->lineCount + 1, sizeof(AdvLayoutLine))) return false;
+    AdvLayoutLine* line = &layout->lines[layout->lineCount++];
+    memset(line, 0, sizeof(*line));
+    line->y = y;
+    line->firstGlyph = firstGlyph;
+    line->run = run;
+    line->textOffset = textOffset;
+    return true;
+}
+
+// 全域背景：包覆整段文字 (不受 charLimit 影響，總是顯示全文大小)
+static Rectangle GetGlobalBgRec(const AdvTextStyle* style, float width, float height)
+{
+    float bgW = width + style->bgPaddingX * 2;
+    float bgX = -bgW / 2.0f; // 預設 Center Align 的背景位置
+    if (style->align == TEXT_ALIGN_LEFT) bgX = -style->bgPaddingX;
+    else if (style->align == TEXT_ALIGN_RIGHT) bgX = -bgW + style->bgPaddingX;
+    return (Rectangle){ bgX, -style->bgPaddingY, bgW, height + style->bgPaddingY * 2 };
+}
+
+// 排版取得字形資料 (複製一份：背景排版放開鎖後，快取中的字形可能被其他執行緒回收)
+// shared 為 true 時呼叫端持有讀鎖：先唯讀查詢，缺字時才換成寫鎖建立，完成後換回讀鎖
+// 讀鎖下命中不更新 lastUsed，由繪製前的 PrepareLayoutForDraw 釘住
+static bool FetchLayoutGlyph(bool shared, unsigned int key, AdvGlyph* out, int* slot)
+{
+    if (shared) {
+        int idx = GlyphIndexFind(key);
+        if (idx != -1) {
+            *out = g_ctx.cache[idx];
+            *slot = idx;
+#if defined(ADVTEXT_ENABLE_STATS)
+            g_sharedHits++;
+#endif
+            return true;
+        }
+        UpgradeContextLock();
+    }
+
+    AdvGlyph* g = GetGlyph(key);
+    bool found = (g != NULL);
+    if (g) {
+        *out = *g;
+        *slot = (int)(g - g_ctx.cache);
+    } else {
+        // 快取放不下 (本幀的字形已佔滿)：仍以度量資訊排版，插槽為 -1，繪製前再重新取得
+        int w, h;
+        found = MeasureGlyph(key, out, &w, &h);
+        *slot = -1;
+    }
+    if (shared) DowngradeContextLock();
+    return found;
+}
+
+// 排版解析碼點的字型 (規則同 FetchLayoutGlyph)
+static int FetchLayoutFont(bool shared, int font, int cp)
+{
+    int resolved = shared ? FindGlyphFont(font, cp) : -1;
+    if (resolved >= 0) return resolved;
+
+    if (shared) UpgradeContextLock();
+    resolved = ResolveGlyphFont(font, cp);
+    if (shared) DowngradeContextLock();
+    return resolved;
+}
+
+// 排版取得 (字型, 字號) 組合 (規則同 FetchLayoutGlyph)
+static int FetchLayoutStrike(bool shared, int font, int size)
+{
+    int strike = shared ? FindStrike(font, size) : -1;
+    if (strike >= 0) return strike;
+
+    if (shared) UpgradeContextLock();
+    strike = GetStrike(font, size);
+    if (shared) DowngradeContextLock();
+    return strike;
+}
+
+// 取得字型在排版字號下的 strike，記下其版本並加入 strikeMask
+static void BindLayoutStrike(AdvTextLayout* layout, bool shared, int font)
+{
+    StrikeBinding* b = &layout->strikes;
+    int strike = FetchLayoutStrike(shared, font, b->size);
+    b->strike[font] = strike;
+    b->epoch[font] = g_ctx.strikes[strike].epoch;
+    layout->strikeMask |= 1u << strike;
+}
+
+// 確認記錄的 strike 仍是原本的 (字型, 字號)；被回收的重新取得 (度量相同，位置不需重排)
+// remap 填入舊編號 -> 新編號，strikeMask 依結果重建；回傳是否有 strike 改變 (渲染執行緒持有寫鎖時呼叫)
+static bool RebindStrikes(StrikeBinding* b, unsigned int* strikeMask, int remap[MAX_STRIKES])
+{
+    if (b->size <= 0) return false;
+    bool changed = false;
+    for (int f = 0; f < MAX_FONTS; f++) {
+        int idx = b->strike[f];
+        if (idx < 0) continue;
+        const AdvStrike* st = &g_ctx.strikes[idx];
+        if (st->active && st->epoch == b->epoch[f]) continue;
+
+        if (!changed) {
+            for (int i = 0; i < MAX_STRIKES; i++) remap[i] = i;
+            changed = true;
+        }
+        int n = GetStrike(f, b->size);
+        remap[idx] = n;
+        b->strike[f] = n;
+        b->epoch[f] = g_ctx.strikes[n].epoch;
+    }
+    if (!changed) return false;
+
+    *strikeMask = 0;
+    for (int f = 0; f < MAX_FONTS; f++) {
+        if (b->strike[f] >= 0) *strikeMask |= 1u << b->strike[f];
+    }
+    return true;
+}
+
+// 把字形鍵改成新的 strike 編號，並清掉插槽讓繪製前重新取得 (不會沿用舊字號的點陣)
+static void RemapGlyphStrike(AdvLayoutGlyph* lg, const int remap[MAX_STRIKES])
+{
+    int strike = GLYPH_KEY_STRIKE(lg->key);
+    if (remap[strike] == strike) return;
+    lg->key = (lg->key & 0x07FFFFFFu) | ((unsigned int)remap[strike] << 27);
+    lg->slot = lg->outlineSlot = -1;
+    lg->page = lg->outlinePage = -1;
+}
+
+// 排版用到的 strike 被回收時改寫所有字形鍵
+static void RebindLayoutStrikes(AdvTextLayout* layout)
+{
+    int remap[MAX_STRIKES];
+    if (!RebindStrikes(&layout->strikes, &layout->strikeMask, remap)) return;
+    for (int i = 0; i < layout->glyphCount; i++) RemapGlyphStrike(&layout->glyphs[i], remap);
+    TraceLog(LOG_DEBUG, "AdvText: Layout font size %d rebound after its size slot was recycled", layout->strikes.size);
+}
+
+// 排版取得字距調整 (規則同 FetchLayoutGlyph)
+static int FetchLayoutKern(bool shared, int font, int left, int right)
+{
+    int kern = 0;
+    if (shared && FindKernAdvance(font, left, right, &kern)) return kern;
+
+    if (shared) UpgradeContextLock();
+    kern = GetKernAdvance(font, left, right);
+    if (shared) DowngradeContextLock();
+    return kern;
+}
+
+// 取得並記錄描邊字形在圖集中的位置 (不描邊時清空)
+static void BindLayoutOutline(AdvTextLayout* layout, AdvLayoutGlyph* lg, bool shared)
+{
+    AdvGlyph og;
+    int slot = -1;
+    unsigned int key = MAKE_OUTLINE_KEY(GLYPH_KEY_STRIKE(lg->key), GLYPH_KEY_CODEPOINT(lg->key), layout->outlineRadius);
+    if (layout->outlineRadius <= 0 || !FetchLayoutGlyph(shared, key, &og, &slot) || slot < 0) {
+        lg->outlineSlot = -1;
+        lg->outlinePage = -1;
+        lg->outlineRec = (Rectangle){ 0 };
+        return;
+    }
+    lg->outlineSlot = slot;
+    lg->outlineSerial = og.serial;
+    lg->outlineRec = og.srcRec;
+    lg->outlinePage = og.ready ? og.page : -1;
+    if (og.ready) layout->pageMask |= 1u << og.page;
+}
+
+// 確認字形的插槽沒有被回收、清空或寫入新點陣，變更過才重新取得圖集位置 (排版與 bearing 不變)，並釘住本幀使用
+// 只有插槽版本不同的字形需要查詢，其餘字形只比對一次；渲染執行緒持有寫鎖時呼叫
+static void RevalidateLayoutGlyph(AdvTextLayout* layout, AdvLayoutGlyph* lg)
+{
+    AdvGlyph* cached = (lg->slot >= 0) ? &g_ctx.cache[lg->slot] : NULL;
+    if (cached && cached->serial == lg->serial) {
+        TouchGlyph(cached);
+    } else {
+        AdvGlyph* g = GetGlyph(lg->key);
+        if (g) {
+            lg->slot = (int)(g - g_ctx.cache);
+            lg->serial = g->serial;
+            lg->srcRec = g->srcRec;
+            lg->page = g->ready ? g->page : -1;
+            if (g->ready) layout->pageMask |= 1u << g->page;
+        } else {
+            lg->page = -1; // 暫時無法取得 (版本仍不同，下次繪製再試)
+        }
+    }
+
+    if (layout->outlineRadius <= 0) return;
+    cached = (lg->outlineSlot >= 0) ? &g_ctx.cache[lg->outlineSlot] : NULL;
+    if (cached && cached->serial == lg->outlineSerial) TouchGlyph(cached);
+    else BindLayoutOutline(layout, lg, false);
+}
+
+// 排版字形是否正在背景點陣化 (有插槽且插槽仍是同一個字形，只是點陣還沒寫入)
+// 沒有插槽或取得失敗的字形不算：它們可能永遠無法快取，等待只會讓呼叫端卡住
+static bool IsLayoutGlyphPending(const AdvLayoutGlyph* lg)
+{
+    if (lg->slot < 0) return false;
+    const AdvGlyph* g = &g_ctx.cache[lg->slot];
+    return (g->active && g->serial == lg->serial && !g->ready);
+}
+
+// 依 style.maxWidth 把斷行項目分行，寫入字形位置、行資訊與整體尺寸 (排版與重新換行共用)
+// 每行從行首以二分搜尋找出第一個放不下的字 (項目位置不是遞增時改為逐一檢查)，退回最後一個斷行機會；
+// 放不下的是空白時讓空白懸掛在行尾，整行沒有斷行機會時在放不下的字之前強制斷行 (每行至少一個字)
+static void WrapLayoutLines(AdvTextLayout* layout, float y)
+{
+    const AdvLayoutItem* items = layout->items;
+    int count = layout->itemCount;
+    long long maxW = (layout->style.maxWidth > 0) ? TO_LAYOUT_UNITS(layout->style.maxWidth) : 0;
+    float gs = layout->glyphScale;
+    int glyph = 0;
+
+    layout->lineCount = 0;
+    layout->width = 0.0f;
+
+    int i = 0;
+    while (i < count) {
+        const AdvLayoutItem* head = &items[i];
+        int end = head->nextNewline;        // 本段落到換行字元為止
+        int lineEnd = end, next = end + 1;  // 本行的項目為 [i, lineEnd)，下一行從 next 開始
+
+        if (maxW > 0 && end > i + 1) {
+            long long limit = head->penX + maxW;
+            int lo = i + 1, hi = end;
+            if (layout->itemsUnordered) {
+                // 結尾位置不是遞增的：二分搜尋可能跳過中間超出寬度的字，逐一找出第一個放不下的字
+                while (lo < end && items[lo].penX + items[lo].advance <= limit) lo++;
+            } else {
+                while (lo < hi) {
+                    int mid = (lo + hi) / 2;
+                    if (items[mid].penX + items[mid].advance > limit) hi = mid;
+                    else lo = mid + 1;
+                }
+            }
+
+            if (lo < end) {
+                int b = lo;
+                if (items[lo].flags & LAYOUT_ITEM_SPACE) {
+                    while (b < end && (items[b].flags & LAYOUT_ITEM_SPACE)) b++;
+                }
+                if (b > lo && (b == end || (items[b].flags & LAYOUT_ITEM_BREAK))) {
+                    lineEnd = b;                            // 空白懸掛在行尾
+                    next = (b == end) ? end + 1 : b;
+                } else if (items[lo].prevBreak > i) {
+                    lineEnd = next = items[lo].prevBreak;   // 退回最後一個斷行機會
+                } else {
+                    lineEnd = next = lo;                    // 沒有斷行機會：強制斷行
+                }
+            }
+        }
+
+        if (!BeginLayoutLine(layout, y, glyph, head->run, head->textOffset)) break;
+        AdvLayoutLine* line = &layout->lines[layout->lineCount - 1];
+        line->firstItem = i;
+
+        // 行尾空白不計入行寬 (對齊時不會往左偏；長文件分段排版的最後一行也得到相同的行寬)
+        int last = lineEnd - 1;
+        while (last >= i && (items[last].flags & LAYOUT_ITEM_SPACE)) last--;
+        long long lineEndX = (last >= i) ? items[last].penX + items[last].advance : head->penX;
+        for (int j = i; layout->itemsUnordered && j < last; j++) {
+            if (items[j].penX + items[j].advance > lineEndX) lineEndX = items[j].penX + items[j].advance; // 行寬取最遠的結尾
+        }
+        float lineW = (float)(lineEndX - head->penX) / LAYOUT_UNITS_PER_PIXEL;
+
+        for (int j = i; j < lineEnd; j++) {
+            AdvLayoutGlyph* lg = &layout->glyphs[glyph++];
+            float penX = (float)(items[j].penX - head->penX) / LAYOUT_UNITS_PER_PIXEL;
+            // 點陣模式的筆位置取整數像素 (小數只保留在累加中)，避免取樣時字形變模糊
+            if (gs == 1.0f) penX = (float)(int)(penX + 0.5f);
+            lg->offset = (Vector2){ penX + items[j].bearing.x, y + layout->ascent + items[j].bearing.y };
+        }
+        line->glyphCount = lineEnd - i;
+
+        EndLayoutLine(layout, lineW, layout->lineHeight);
+        y += layout->lineHeight;
+        i = next;
+    }
+
+    layout->height = layout->lineCount * layout->lineHeight;
+    layout->globalBgRec = GetGlobalBgRec(&layout->style, layout->width, layout->height);
+}
+
+// 排版：解析標籤、取得字形並記錄斷行項目，再由 WrapLayoutLines 換行與對齊，結果寫入 layout (重複使用其容量)
+// shared 為 true 時可在背景執行緒呼叫：自行取讀鎖，缺字時短暫換成寫鎖 (否則呼叫端已持有寫鎖)
+// range 不為 NULL 時只排版其中一段，沿用 layout->runs 中已解析的片段
+static void LayoutRichText(AdvTextLayout* layout, const char* text, AdvTextStyle style, bool shared, const LayoutRange* range)
+{
+    if (shared) LockContext(false);
+    STAT_ZONE_BEGIN(start, "AdvText Layout");
+
+    layout->ctx = g_current;
+    layout->style = NormalizeStyle(style);
+    layout->glyphCount = 0;
+    layout->lineCount = 0;
+    layout->width = 0.0f;
+    layout->height = 0.0f;
+    layout->pageMask = 0;
+    layout->strikeMask = 0;
+
+    style = layout->style;
+
+    // 點陣模式：字號取整數像素，每種 (字型, 字號) 各自快取字形，度量查表取得
+    int size, variant;
+    GetStyleGlyphParams(&style, &size, &variant, &layout->outlineRadius);
+    StrikeBinding* strikes = &layout->strikes; // 本次排版中每個字型對應的 strike (-1 表示尚未查詢)
+    for (int i = 0; i < MAX_FONTS; i++) strikes->strike[i] = -1;
+    strikes->size = size;
+    BindLayoutStrike(layout, shared, 0);
+    const int* fontStrike = strikes->strike;
+
+    const AdvStrike* lineStrike = &g_ctx.strikes[fontStrike[0]];
+    float ascent = (float)lineStrike->ascent;
+    float lineHeight = (float)(lineStrike->ascent - lineStrike->descent + lineStrike->lineGap) * style.lineSpacing;
+    layout->glyphScale = 1.0f;
+
+    // SDF 模式：字形以 SDF_BASE_SIZE 產生，度量依 fontSize 縮放
+    if (style.enableSDF) {
+        const AdvFont* font = &g_ctx.fonts[0];
+        float scale = stbtt_ScaleForPixelHeight(&font->info, style.fontSize);
+        ascent = font->ascent * scale;
+        lineHeight = (font->ascent - font->descent + font->lineGap) * scale * style.lineSpacing;
+        layout->glyphScale = style.fontSize / SDF_BASE_SIZE;
+    }
+    float gs = layout->glyphScale; // 點陣模式的描邊使用預先擴張的描邊字形 (SDF 模式在著色器中描邊)
+    // 標籤先解析成片段 (顏色與字型已套用樣式堆疊)，排版只走訪片段中的文字
+    const TextRunList* runs = &layout->runs;
+    if (!range) TokenizeRichText(&layout->runs, text, style.baseColor);
+
+    // 第一趟：取得字形並記錄斷行項目 (不換行時的筆位置與斷行機會)，換行交給 WrapLayoutLines
+    layout->itemCount = 0;
+    layout->ascent = ascent;
+    layout->lineHeight = lineHeight;
+    int prevFont = -1, prevGlyph = 0;    // 上一個字 (字距調整用，換行字元之後不套用)
+    int prevClass = -1;                  // 上一個非結合字元的斷行類別 (-1 表示段落開頭)
+    bool joined = false;                 // 上一個字是零寬連接符 (表情符號序列中不斷行)
+    int prevBreak = -1;
+    long long penX = 0;
+    long long prevPenX = -1, prevEndX = -1; // 段落中前一項的筆位置與結尾 (檢查是否遞增)
+    layout->itemsUnordered = false;
+    int run = range ? range->run : 0, idx = range ? range->start : 0, cp = 0, bytes = 0;
+    const TextRun* tr = NULL;
+
+    while ((tr = PeekRunCodepoint(runs, text, &run, &idx, &cp, &bytes)) != NULL) {
+        if (range && idx >= range->end) break;
+        if (!ReserveArray((void**)&layout->items, &layout->itemCapacity, layout->itemCount + 1, sizeof(AdvLayoutItem))) break;
+        AdvLayoutItem* item = &layout->items[layout->itemCount];
+        item->run = run;
+        item->textOffset = idx;
+
+        if (cp == '\n') {
+            *item = (AdvLayoutItem){ .penX = penX, .run = run, .textOffset = idx, .prevBreak = -1, .flags = LAYOUT_ITEM_NEWLINE };
+            layout->itemCount++;
+            prevFont = -1;
+            prevClass = -1;
+            joined = false;
+            prevBreak = -1;
+            prevPenX = prevEndX = -1;
+            idx += bytes;
+            continue;
+        }
+
+        int font = FetchLayoutFont(shared, tr->font, cp);
+        if (fontStrike[font] < 0) BindLayoutStrike(layout, shared, font);
+        unsigned int key = MAKE_GLYPH_KEY(fontStrike[font], cp, variant);
+        AdvGlyph g;
+        int slot = -1;
+        if (!FetchLayoutGlyph(shared, key, &g, &slot)) { idx += bytes; continue; }
+
+        // 字距：同一字型的相鄰字之間套用 (行首的字距在換行時捨去)
+        if (font == prevFont) {
+            float kern = FetchLayoutKern(shared, font, prevGlyph, g.glyphIndex) * g_ctx.strikes[fontStrike[font]].scale * gs;
+            penX += TO_LAYOUT_UNITS(kern);
+        }
+        prevFont = font;
+        prevGlyph = g.glyphIndex;
+
+        int cls = GetBreakClass(cp);
+        item->flags = (cls == BREAK_CLASS_SP) ? LAYOUT_ITEM_SPACE : 0;
+        if (prevClass >= 0 && !joined && CanBreakBetween(prevClass, cls)) {
+            item->flags |= LAYOUT_ITEM_BREAK;
+            prevBreak = layout->itemCount;
+        }
+        if (cls != BREAK_CLASS_CM) prevClass = cls;
+        else if (prevClass < 0) prevClass = BREAK_CLASS_AL; // 段落開頭的結合字元視為字母
+        joined = (cp == 0x200D);
+
+        if (!ReserveArray((void**)&layout->glyphs, &layout->glyphCapacity, layout->glyphCount + 1, sizeof(AdvLayoutGlyph))) break;
+        AdvLayoutGlyph* lg = &layout->glyphs[layout->glyphCount++];
+        lg->key = key;
+        lg->slot = slot;
+        lg->serial = g.serial;
+        lg->srcRec = g.srcRec;
+        lg->page = g.ready ? g.page : -1;
+        if (g.ready) layout->pageMask |= 1u << g.page;
+        lg->color = tr->color;
+        lg->textOffset = idx;
+        BindLayoutOutline(layout, lg, shared);
+
+        item->penX = penX;
+        item->advance = (int)TO_LAYOUT_UNITS(g.advance * gs);
+        item->bearing = (Vector2){ g.bearingX * gs, g.bearingY * gs };
+        item->prevBreak = prevBreak;
+        layout->itemCount++;
+
+        if (prevEndX >= 0 && (penX < prevPenX || penX + item->advance < prevEndX)) layout->itemsUnordered = true;
+        prevPenX = penX;
+        prevEndX = penX + item->advance;
+        penX += item->advance;
+        idx += bytes;
+    }
+
+    // 每一項之後的第一個換行字元 (分行時不需往後掃描)
+    int nextNewline = layout->itemCount;
+    for (int i = layout->itemCount - 1; i >= 0; i--) {
+        if (layout->items[i].flags & LAYOUT_ITEM_NEWLINE) nextNewline = i;
+        layout->items[i].nextNewline = nextNewline;
+    }
+
+    // 第二趟：分行、寫入字形位置與對齊
+    WrapLayoutLines(layout, range ? range->y : 0.0f);
+
+    // 排版途中若觸發 Flush 或回收，前面字形的插槽版本已不同，繪製前的 PrepareLayoutForDraw 會重新取得
+
+#if defined(ADVTEXT_ENABLE_STATS)
+    unsigned long long layoutNs = EndStatZone("AdvText Layout", start);
+    if (shared) {
+        STAT_ADD_SHARED(layoutNs, layoutNs);
+        STAT_ADD_SHARED(cacheHits, g_sharedHits);
+        g_sharedHits = 0;
+    } else {
+        STAT_ADD(layoutNs, layoutNs);
+    }
+#endif
+    if (shared) UnlockContext();
+}
+
+// 繪製前的準備：寫入背景完成的字形、重新取得插槽已變更的字形、釘住本幀使用的字形並上傳圖集
+// 回傳要繪製的字形數 (套用 charLimit)
+static int PrepareLayoutForDraw(AdvTextLayout* layout, int charLimit)
+{
+    ProcessRasterResults();
+    RebindLayoutStrikes(layout);
+
+    // 釘住排版用到的字號，字號表滿時不會回收仍在畫面上的組合
+    for (int i = 0; i < MAX_STRIKES; i++) {
+        if (layout->strikeMask & (1u << i)) g_ctx.strikes[i].lastUsed = g_ctx.frame;
+    }
+
+    int glyphEnd = layout->glyphCount;
+    if (charLimit >= 0 && charLimit < glyphEnd) glyphEnd = charLimit;
+
+    // 途中觸發整個清空 (沒有幀邊界時) 會把前面已確認的字形所在區域配給新字形：重來一次，
+    // 前面的字形插槽版本已不同，會重新取得；清空後仍放不下整段時，過期的字形這次不繪製
+    for (int attempt = 0; ; attempt++) {
+        unsigned int flushes = g_ctx.flushCount;
+        for (int i = 0; i < glyphEnd; i++) RevalidateLayoutGlyph(layout, &layout->glyphs[i]);
+        if (g_ctx.flushCount == flushes) break;
+        if (attempt == PREPARE_FLUSH_RETRIES) {
+            for (int i = 0; i < glyphEnd; i++) {
+                AdvLayoutGlyph* lg = &layout->glyphs[i];
+                if (lg->slot < 0 || g_ctx.cache[lg->slot].serial != lg->serial) lg->page = -1;
+                if (lg->outlineSlot >= 0 && g_ctx.cache[lg->outlineSlot].serial != lg->outlineSerial) lg->outlinePage = -1;
+            }
+            break;
+        }
+    }
+
+    // 本次新點陣化的字形一次上傳
+    UploadAtlasPages();
+    return glyphEnd;
+}
+
+// 加入一個四邊形 (空白字形不佔圖集，直接略過)
+static void PushDrawQuad(AdvTextDrawList* list, Rectangle src, Rectangle dest, Color color, int page)
+{
+    if (src.width <= 0 || src.height <= 0) return;
+    if (!ReserveArray((void**)&list->quads, &list->capacity, list->count + 1, sizeof(AdvTextQuad))) return;
+
+    AdvTextQuad* q = &list->quads[list->count++];
+    q->dest = dest;
+    q->uv = (Rectangle){ src.x / ATLAS_SIZE, src.y / ATLAS_SIZE, src.width / ATLAS_SIZE, src.height / ATLAS_SIZE };
+    q->color = color;
+    q->page = page;
+}
+
+// 把排版結果轉成四邊形清單 (附加在 list 後面)
+// 依圖層排列 (陰影 -> 描邊 -> 本體)，每層內依圖集頁分組，提交時每頁一個批次
+// SDF 模式只輸出本體，陰影與描邊在著色器中合成
+static void EmitLayoutQuads(AdvTextDrawList* list, const AdvTextLayout* layout, Vector2 pos, int glyphEnd)
+{
+    const AdvTextStyle* style = &layout->style;
+    float gs = layout->glyphScale;
+    float r = (float)layout->outlineRadius;
+
+    for (int layer = 0; layer < 3; layer++) {
+        if (layer == 0 && (!style->enableShadow || style->enableSDF)) continue;
+        if (layer == 1 && layout->outlineRadius <= 0) continue;
+
+        for (int p = 0; p < g_ctx.pageCount; p++) {
+            if (!(layout->pageMask & (1u << p))) continue;
+
+            for (int i = 0; i < glyphEnd; i++) {
+                const AdvLayoutGlyph* lg = &layout->glyphs[i];
+                if ((layer == 1 ? lg->outlinePage : lg->page) != p) continue;
+                float x = pos.x + lg->offset.x, y = pos.y + lg->offset.y;
+
+                if (layer == 0) {
+                    Rectangle dest = { x + style->shadowOffset.x, y + style->shadowOffset.y, lg->srcRec.width, lg->srcRec.height };
+                    PushDrawQuad(list, lg->srcRec, dest, style->shadowColor, p);
+                } else if (layer == 1) {
+                    // 描邊是預先擴張好的字形，每個字只多一個四邊形
+                    Rectangle dest = { x - r, y - r, lg->outlineRec.width, lg->outlineRec.height };
+                    PushDrawQuad(list, lg->outlineRec, dest, style->outlineColor, p);
+                } else {
+                    Rectangle dest = { x, y, lg->srcRec.width * gs, lg->srcRec.height * gs };
+                    PushDrawQuad(list, lg->srcRec, dest, lg->color, p);
+                }
+            }
+        }
+    }
+}
+
+// 透過 rlgl 直接提交四邊形：同一頁連續的四邊形在同一個 rlBegin(RL_QUADS) 中送出
+static void SubmitDrawQuads(const AdvTextQuad* quads, int count)
+{
+    int i = 0;
+    while (i < count) {
+        int page = quads[i].page;
+        int end = i;
+        while (end < count && end - i < DRAW_BATCH_QUADS && quads[end].page == page) end++;
+        if (page < 0 || page >= g_ctx.pageCount) { i = end; continue; }
+
+        // 批次緩衝區不夠時先送出 (不會在 rlBegin/rlEnd 之間切斷)
+        rlCheckRenderBatchLimit((end - i) * 4);
+        rlSetTexture(g_ctx.pages[page].texture.id);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        for (; i < end; i++) {
+            const AdvTextQuad* q = &quads[i];
+            float x0 = q->dest.x, y0 = q->dest.y;
+            float x1 = x0 + q->dest.width, y1 = y0 + q->dest.height;
+            float u0 = q->uv.x, v0 = q->uv.y;
+            float u1 = u0 + q->uv.width, v1 = v0 + q->uv.height;
+
+            rlColor4ub(q->color.r, q->color.g, q->color.b, q->color.a);
+            rlTexCoord2f(u0, v0); rlVertex2f(x0, y0); // 左上
+            rlTexCoord2f(u0, v1); rlVertex2f(x0, y1); // 左下
+            rlTexCoord2f(u1, v1); rlVertex2f(x1, y1); // 右下
+            rlTexCoord2f(u1, v0); rlVertex2f(x1, y0); // 右上
+        }
+        rlEnd();
+        rlSetTexture(0);
+        STAT_ADD(drawCalls, 1);
+    }
+    STAT_ADD(quads, (unsigned int)count);
+}
+
+// SDF 模式：設定著色器參數後提交 (陰影與描邊在著色器中合成)
+static void SubmitDrawQuadsSDF(const AdvTextLayout* layout, const AdvTextQuad* quads, int count)
+{
+    const AdvTextStyle* style = &layout->style;
+    if (!LoadSDFShader()) return;
+
+    // 螢幕上一個像素對應的距離值變化 (圖集中一個像素為 SDF_PIXEL_DIST_SCALE / 255)
+    float gs = layout->glyphScale;
+    float pixelDist = (SDF_PIXEL_DIST_SCALE / 255.0f) / gs;
+    float smoothing = 0.5f * pixelDist;
+    float outlineWidth = style->enableOutline ? style->outlineThickness * pixelDist : 0.0f;
+    if (outlineWidth > 0.45f) outlineWidth = 0.45f; // 不能超出距離場的範圍
+
+    // 陰影偏移換算成圖集 UV，限制在 SDF_PADDING 內，避免取樣到相鄰字形
+    Vector2 shadowOffset = { 0 };
+    if (style->enableShadow) {
+        float limit = (float)(SDF_PADDING - 1);
+        float sx = style->shadowOffset.x / gs, sy = style->shadowOffset.y / gs;
+        if (sx > limit) sx = limit; else if (sx < -limit) sx = -limit;
+        if (sy > limit) sy = limit; else if (sy < -limit) sy = -limit;
+        shadowOffset = (Vector2){ sx / ATLAS_SIZE, sy / ATLAS_SIZE };
+    }
+
+    // 關閉的效果以透明色傳入 (著色器不需分支)
+    Vector4 outlineColor = ColorNormalize(style->enableOutline ? style->outlineColor : BLANK);
+    Vector4 shadowColor = ColorNormalize(style->enableShadow ? style->shadowColor : BLANK);
+
+    const SDFShader* sdf = &g_ctx.sdf;
+    SetShaderValue(sdf->shader, sdf->outlineColorLoc, &outlineColor, SHADER_UNIFORM_VEC4);
+    SetShaderValue(sdf->shader, sdf->outlineWidthLoc, &outlineWidth, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(sdf->shader, sdf->shadowColorLoc, &shadowColor, SHADER_UNIFORM_VEC4);
+    SetShaderValue(sdf->shader, sdf->shadowOffsetLoc, &shadowOffset, SHADER_UNIFORM_VEC2);
+    SetShaderValue(sdf->shader, sdf->smoothingLoc, &smoothing, SHADER_UNIFORM_FLOAT);
+
+    BeginShaderMode(sdf->shader);
+    SubmitDrawQuads(quads, count);
+    EndShaderMode();
+}
+
+// 繪製排版結果 (穩定狀態下只是一個攤平的迴圈)
+static void DrawLayout(AdvTextLayout* layout, Vector2 pos, int charLimit)
+{
+    STAT_ZONE_BEGIN(start, "AdvText Draw");
+    int glyphEnd = PrepareLayoutForDraw(layout, charLimit);
+    if (g_ctx.flags & ADVTEXT_FLAG_HEADLESS) { // 沒有 GPU：只排版與點陣化
+        STAT_ZONE_END(start, "AdvText Draw", drawNs);
+        return;
+    }
+
+    const AdvTextStyle* style = &layout->style;
+
+    // 繪製 Global Background (如果啟用)
+    if (style->enableBackground && style->enableGlobalBackground && layout->width > 0) {
+        Rectangle bgRec = layout->globalBgRec;
+        bgRec.x += pos.x;
+        bgRec.y += pos.y;
+        DrawRectangleRounded(bgRec, 0.1f, 8, style->backgroundColor);
+    }
+
+    // 繪製行背景 (如果未啟用 Global Background)
+    if (style->enableBackground && !style->enableGlobalBackground) {
+        for (int l = 0; l < layout->lineCount; l++) {
+            const AdvLayoutLine* line = &layout->lines[l];
+            if (charLimit >= 0 && line->firstGlyph >= charLimit) break;
+
+            Rectangle bgRec = line->bgRec;
+            bgRec.x += pos.x;
+            bgRec.y += pos.y;
+            DrawRectangleRounded(bgRec, 0.2f, 4, style->backgroundColor);
+        }
+    }
+
+    // 字形轉成四邊形清單 (重複使用內部緩衝區)，每頁一個批次送出
+    AdvTextDrawList* list = &g_ctx.drawList;
+    list->count = 0;
+    EmitLayoutQuads(list, layout, pos, glyphEnd);
+    if (style->enableSDF) SubmitDrawQuadsSDF(layout, list->quads, list->count);
+    else SubmitDrawQuads(list->quads, list->count);
+    STAT_ZONE_END(start, "AdvText Draw", drawNs);
+}
+
+// 釋放排版結果佔用的陣列
+static void ClearLayout(AdvTextLayout* layout)
+{
+    MemFree(layout->glyphs);
+    MemFree(layout->lines);
+    MemFree(layout->items);
+    MemFree(layout->runs.runs);
+    memset(layout, 0, sizeof(*layout));
+}
+
+// 建立長文件的行索引：整份排版一次，只留下每行的起點 (字形陣列之後只用於可見範圍)
+static bool BuildDocumentIndex(AdvTextDocument* doc, AdvTextStyle style)
+{
+    AdvTextLayout* layout = &doc->window;
+    int length = (int)strlen(doc->text);
+    TokenizeRichText(&layout->runs, doc->text, style.baseColor);
+    LayoutRange all = { 0, 0, length, 0.0f };
+    LayoutRichText(layout, doc->text, style, false, &all);
+
+    doc->lines = (AdvDocumentLine*)MemAlloc((layout->lineCount + 1) * sizeof(AdvDocumentLine));
+    if (!doc->lines) return false;
+    for (int i = 0; i < layout->lineCount; i++) {
+        const AdvLayoutLine* line = &layout->lines[i];
+        doc->lines[i] = (AdvDocumentLine){ line->textOffset, line->run, line->y };
+    }
+    doc->lines[layout->lineCount] = (AdvDocumentLine){ length, layout->runs.count, layout->height };
+    doc->lineCount = layout->lineCount;
+    doc->width = layout->width;
+    doc->height = layout->height;
+    doc->lineHeight = (layout->lineCount > 0) ? layout->height / layout->lineCount : 0.0f;
+
+    // 全文的字形與行陣列可能很大，釋放後由可見範圍重新配置
+    MemFree(layout->glyphs);
+    MemFree(layout->lines);
+    MemFree(layout->items);
+    layout->glyphs = NULL;
+    layout->lines = NULL;
+    layout->items = NULL;
+    layout->glyphCount = layout->glyphCapacity = 0;
+    layout->lineCount = layout->lineCapacity = 0;
+    layout->itemCount = layout->itemCapacity = 0;
+    doc->firstLine = doc->endLine = 0;
+    return true;
+}
+
+// 找出包含 y 的行 (y 在第一行之上回傳 0)
+static int FindDocumentLine(const AdvTextDocument* doc, float y)
+{
+    int lo = 0, hi = doc->lineCount - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (doc->lines[mid].y <= y) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+// 只重新排版 [top, bottom) 範圍內的行 (上下各多一行，容納陰影、描邊與超出行高的字形)；範圍不變時沿用上次的結果
+static void UpdateDocumentWindow(AdvTextDocument* doc, float top, float bottom)
+{
+    int first = FindDocumentLine(doc, top) - 1;
+    int end = FindDocumentLine(doc, bottom) + 2;
+    if (first < 0) first = 0;
+    if (end > doc->lineCount) end = doc->lineCount;
+    if (first == doc->firstLine && end == doc->endLine) return;
+
+    AdvTextLayout* layout = &doc->window;
+    doc->firstLine = first;
+    doc->endLine = end;
+    if (first >= end) {
+        layout->glyphCount = 0;
+        layout->lineCount = 0;
+        return;
+    }
+
+    LayoutRange range = { doc->lines[first].run, doc->lines[first].textOffset, doc->lines[end].textOffset, doc->lines[first].y };
+    LayoutRichText(layout, doc->text, layout->style, false, &range);
+    layout->globalBgRec = GetGlobalBgRec(&layout->style, doc->width, doc->height);
+}
+
+// 擠出串流最舊的一行 (連同它在字形環中的字形)
+static void DropStreamLine(AdvTextStream* stream)
+{
+    const AdvStreamLine* line = &stream->lines[stream->oldest];
+    stream->glyphStart = (stream->glyphStart + line->glyphCount) % stream->glyphCapacity;
+    stream->glyphCount -= line->glyphCount;
+    stream->oldest = (stream->oldest + 1) % stream->maxLines;
+    stream->lineCount--;
+}
+
+// 把暫存排版的一行移入環中 (字形 y 改成相對於行頂；比整個字形環還長的行截斷到環的容量)
+static void PushStreamLine(AdvTextStream* stream, const AdvTextLayout* layout, const AdvLayoutLine* src)
+{
+    int count = src->glyphCount;
+    if (count > stream->glyphCapacity) {
+        TraceLog(LOG_WARNING, "AdvText: Stream line of %d glyphs exceeds the glyph ring (%d), truncated (raise maxGlyphBytes or set maxWidth)",
+                 count, stream->glyphCapacity);
+        count = stream->glyphCapacity;
+    }
+    while (stream->lineCount > 0 && (stream->lineCount >= stream->maxLines ||
+                                     stream->glyphCount + count > stream->glyphCapacity)) {
+        DropStreamLine(stream);
+    }
+
+    int first = (stream->glyphStart + stream->glyphCount) % stream->glyphCapacity;
+    for (int i = 0; i < count; i++) {
+        AdvLayoutGlyph* g = &stream->glyphs[(first + i) % stream->glyphCapacity];
+        *g = layout->glyphs[src->firstGlyph + i];
+        g->offset.y -= src->y;
+    }
+    stream->glyphCount += count;
+
+    AdvStreamLine* line = &stream->lines[(stream->oldest + stream->lineCount) % stream->maxLines];
+    line->firstGlyph = first;
+    line->glyphCount = count;
+    line->width = src->width;
+    line->bgRec = src->bgRec;
+    line->bgRec.y -= src->y;
+    stream->lineCount++;
+}
+
+// 保留的行用到的 strike 被回收時改寫環中的字形鍵，並讓可見範圍重建
+static void RebindStreamStrikes(AdvTextStream* stream)
+{
+    int remap[MAX_STRIKES];
+    if (!RebindStrikes(&stream->strikes, &stream->strikeMask, remap)) return;
+    for (int i = 0; i < stream->glyphCount; i++) {
+        RemapGlyphStrike(&stream->glyphs[(stream->glyphStart + i) % stream->glyphCapacity], remap);
+    }
+    stream->serial++;
+}
+
+// 重建可見範圍：從最新一行往回數的 [first, end) 行，複製到 window 並排在錨點 (最新一行底端) 之上
+// 只有捲動跨行或內容改變時才重建，成本與畫面上的行數成正比
+static void UpdateStreamWindow(AdvTextStream* stream, float viewHeight, float scroll)
+{
+    float lh = stream->lineHeight;
+    int first = (int)(scroll / lh) - 1;
+    int end = (int)((scroll + viewHeight) / lh) + 2;
+    if (first < 0) first = 0;
+    if (end > stream->lineCount) end = stream->lineCount;
+    if (first == stream->windowFirst && end == stream->windowEnd && stream->serial == stream->windowSerial) return;
+
+    AdvTextLayout* window = &stream->window;
+    stream->windowFirst = first;
+    stream->windowEnd = end;
+    stream->windowSerial = stream->serial;
+    window->glyphCount = 0;
+    window->lineCount = 0;
+    window->width = 0.0f;
+    window->pageMask = 0;
+    window->strikeMask = stream->strikeMask;
+
+    // 由舊到新排列，繪製順序與一般排版相同 (由上而下)
+    for (int k = end - 1; k >= first; k--) {
+        const AdvStreamLine* src = &stream->lines[(stream->oldest + stream->lineCount - 1 - k) % stream->maxLines];
+        float top = -(k + 1) * lh;
+        if (!ReserveArray((void**)&window->lines, &window->lineCapacity, window->lineCount + 1, sizeof(AdvLayoutLine))) break;
+        if (!ReserveArray((void**)&window->glyphs, &window->glyphCapacity, window->glyphCount + src->glyphCount, sizeof(AdvLayoutGlyph))) break;
+
+        AdvLayoutLine* line = &window->lines[window->lineCount++];
+        memset(line, 0, sizeof(*line));
+        line->y = top;
+        line->width = src->width;
+        line->firstGlyph = window->glyphCount;
+        line->glyphCount = src->glyphCount;
+        line->bgRec = src->bgRec;
+        line->bgRec.y += top;
+        if (src->width > window->width) window->width = src->width;
+
+        for (int i = 0; i < src->glyphCount; i++) {
+            AdvLayoutGlyph* ring = &stream->glyphs[(src->firstGlyph + i) % stream->glyphCapacity];
+            RevalidateLayoutGlyph(&stream->scratch, ring); // 環中的字形也更新，之後重建可見範圍不必再查詢
+            AdvLayoutGlyph* g = &window->glyphs[window->glyphCount++];
+            *g = *ring;
+            g->offset.y += top;
+            if (g->page >= 0) window->pageMask |= 1u << g->page;
+            if (g->outlinePage >= 0) window->pageMask |= 1u << g->outlinePage;
+        }
+    }
+
+    window->height = window->lineCount * lh;
+    window->globalBgRec = GetGlobalBgRec(&window->style, window->width, window->height);
+    window->globalBgRec.y -= end * lh;
+}
+
+// -------------------------------------------------------------------------
+// 靜態文字區塊快取：整個區塊 (背景、陰影、描邊、本體) 畫進渲染紋理一次，之後每幀只畫一個四邊形
+// -------------------------------------------------------------------------
+
+// FNV-1a (64 位元)
+static unsigned long long HashBytes(unsigned long long h, const void* data, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+// 原文與樣式的雜湊 (樣式逐欄位加入，不受結構填充位元組影響；字號已由 NormalizeStyle 填入)
+static unsigned long long HashTextBlock(const char* text, int length, const AdvTextStyle* style)
+{
+    unsigned long long h = HashBytes(14695981039346656037ull, text, length);
+    float metrics[] = { style->maxWidth, style->lineSpacing, style->bgPaddingX, style->bgPaddingY,
+                        style->shadowOffset.x, style->shadowOffset.y, style->outlineThickness, style->fontSize };
+    Color colors[] = { style->baseColor, style->backgroundColor, style->shadowColor, style->outlineColor };
+    unsigned char flags[] = { (unsigned char)style->align, style->enableBackground, style->enableGlobalBackground,
+                              style->enableShadow, style->enableOutline, style->enableSDF };
+    h = HashBytes(h, metrics, sizeof(metrics));
+    h = HashBytes(h, colors, sizeof(colors));
+    return HashBytes(h, flags, sizeof(flags));
+}
+
+static TextBlock* FindTextBlock(unsigned long long key, int length)
+{
+    for (int i = 0; i < MAX_TEXT_BLOCKS; i++) {
+        TextBlock* block = &g_ctx.blocks[i];
+        if (block->active && block->key == key && block->textLength == length) return block;
+    }
+    return NULL;
+}
+
+// 釋放區塊與它的紋理
+static void UnloadTextBlock(TextBlock* block)
+{
+    if (block->target.id > 0) {
+        g_ctx.blockBytes -= block->target.texture.width * block->target.texture.height * 4;
+        UnloadRenderTexture(block->target);
+    }
+    memset(block, 0, sizeof(*block));
+}
+
+// 釋放紋理直到佔用量不超過 budget (先釋放池中的紋理，再依 LRU 釋放區塊)
+static void TrimTextBlocks(int budget)
+{
+    while (g_ctx.blockBytes > budget) {
+        TextBlock* victim = NULL;
+        for (int i = 0; i < MAX_TEXT_BLOCKS; i++) {
+            TextBlock* block = &g_ctx.blocks[i];
+            if (block->target.id == 0) continue;
+            if (!victim || (victim->active && !block->active) ||
+                (victim->active == block->active && block->lastUsed < victim->lastUsed)) victim = block;
+        }
+        if (!victim) break;
+        UnloadTextBlock(victim);
+    }
+}
+
+// 取得一個有 w x h 紋理的區塊：優先重用池中同尺寸的紋理；空間或插槽不足時先釋放池中的紋理，
+// 再把最久未用的區塊放回池中 (本幀用過的不回收)；仍不足時回傳 NULL，由呼叫端直接繪製
+static TextBlock* AcquireTextBlock(int w, int h)
+{
+    int budget = (g_ctx.blockBudget > 0) ? g_ctx.blockBudget : TEXT_BLOCK_BUDGET;
+    int bytes = w * h * 4;
+    if (bytes > budget) return NULL;
+
+    for (;;) {
+        TextBlock* empty = NULL;
+        TextBlock* pooled = NULL;
+        TextBlock* victim = NULL;
+        for (int i = 0; i < MAX_TEXT_BLOCKS; i++) {
+            TextBlock* block = &g_ctx.blocks[i];
+            if (block->target.id == 0) {
+                if (!empty) empty = block;
+            } else if (!block->active) {
+                if (block->target.texture.width == w && block->target.texture.height == h) return block;
+                if (!pooled || block->lastUsed < pooled->lastUsed) pooled = block;
+            } else if (block->lastUsed != g_ctx.frame && (!victim || block->lastUsed < victim->lastUsed)) {
+                victim = block;
+            }
+        }
+
+        if (empty && g_ctx.blockBytes + bytes <= budget) {
+            empty->target = LoadRenderTexture(w, h);
+            if (empty->target.id == 0) return NULL;
+            g_ctx.blockBytes += bytes;
+            return empty;
+        }
+        if (pooled) UnloadTextBlock(pooled);
+        else if (victim) victim->active = false; // 下一輪可能直接重用它的紋理
+        else return NULL;
+    }
+}
+
+static Rectangle UnionRect(Rectangle a, Rectangle b)
+{
+    if (a.width <= 0 || a.height <= 0) return b;
+    if (b.width <= 0 || b.height <= 0) return a;
+    float x0 = fminf(a.x, b.x), y0 = fminf(a.y, b.y);
+    float x1 = fmaxf(a.x + a.width, b.x + b.width), y1 = fmaxf(a.y + a.height, b.y + b.height);
+    return (Rectangle){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+// 排版結果實際繪製的範圍 (含背景、陰影與描邊；相對於繪製位置)
+static Rectangle GetLayoutDrawBounds(const AdvTextLayout* layout)
+{
+    const AdvTextStyle* style = &layout->style;
+    AdvTextDrawList* list = &g_ctx.drawList;
+    list->count = 0;
+    EmitLayoutQuads(list, layout, (Vector2){ 0 }, layout->glyphCount);
+
+    Rectangle bounds = { 0 };
+    for (int i = 0; i < list->count; i++) bounds = UnionRect(bounds, list->quads[i].dest);
+    if (style->enableBackground && style->enableGlobalBackground && layout->width > 0) {
+        bounds = UnionRect(bounds, layout->globalBgRec);
+    } else if (style->enableBackground) {
+        for (int l = 0; l < layout->lineCount; l++) bounds = UnionRect(bounds, layout->lines[l].bgRec);
+    }
+    return bounds;
+}
+
+// 把排版結果畫進區塊紋理：以預乘 Alpha 累積 (紋理以 BLEND_ALPHA_PREMULTIPLY 疊到畫面，半透明邊緣不會變暗)
+// 還有字形在背景點陣化時不快取 (回傳 NULL，這一幀直接繪製)
+static TextBlock* RenderTextBlock(AdvTextLayout* layout, unsigned long long key, int length)
+{
+    PrepareLayoutForDraw(layout, -1);
+    for (int i = 0; i < layout->glyphCount; i++) {
+        const AdvLayoutGlyph* lg = &layout->glyphs[i];
+        if (lg->page < 0 || (lg->outlineSlot >= 0 && lg->outlinePage < 0)) return NULL;
+    }
+
+    Rectangle bounds = GetLayoutDrawBounds(layout);
+    if (bounds.width <= 0 || bounds.height <= 0) return NULL;
+    float x0 = floorf(bounds.x), y0 = floorf(bounds.y);
+    int w = (int)ceilf(bounds.x + bounds.width - x0), h = (int)ceilf(bounds.y + bounds.height - y0);
+    int tw = (w + TEXT_BLOCK_GRANULARITY - 1) / TEXT_BLOCK_GRANULARITY * TEXT_BLOCK_GRANULARITY;
+    int th = (h + TEXT_BLOCK_GRANULARITY - 1) / TEXT_BLOCK_GRANULARITY * TEXT_BLOCK_GRANULARITY;
+
+    TextBlock* block = AcquireTextBlock(tw, th);
+    if (!block) return NULL;
+    block->key = key;
+    block->textLength = length;
+    block->bounds = (Rectangle){ x0, y0, (float)w, (float)h };
+    block->lastUsed = g_ctx.frame;
+    block->active = true;
+
+    BeginTextureMode(block->target);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    DrawLayout(layout, (Vector2){ -x0, -y0 }, -1);
+    EndBlendMode();
+    EndTextureMode();
+    return block;
+}
+
+// 畫出區塊 (渲染紋理上下顛倒，內容在紋理的底部)
+static void DrawTextBlock(const TextBlock* block, Vector2 pos)
+{
+    STAT_ZONE_BEGIN(start, "AdvText Draw");
+    Texture2D texture = block->target.texture;
+    Rectangle src = { 0.0f, texture.height - block->bounds.height, block->bounds.width, -block->bounds.height };
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(texture, src, (Vector2){ pos.x + block->bounds.x, pos.y + block->bounds.y }, WHITE);
+    EndBlendMode();
+    STAT_ADD(quads, 1);
+    STAT_ADD(drawCalls, 1);
+    STAT_ZONE_END(start, "AdvText Draw", drawNs);
+}
+
+// -------------------------------------------------------------------------
+// 量測與點擊測試：排版結果留在小型備忘中，同一幀先量測再繪製只排版一次
+// -------------------------------------------------------------------------
+
+static MeasureMemo* FindMeasureMemo(unsigned long long key, int length)
+{
+    for (int i = 0; i < MAX_MEASURE_MEMOS; i++) {
+        MeasureMemo* memo = &g_ctx.memos[i];
+        if (memo->active && memo->key == key && memo->textLength == length) {
+            memo->lastUsed = g_ctx.frame;
+            return memo;
+        }
+    }
+    return NULL;
+}
+
+// 取得文字的量測備忘：未命中時排版到空格或最久未用的一格 (重複使用其陣列容量)
+static MeasureMemo* AcquireMeasureMemo(const char* text, AdvTextStyle style)
+{
+    style = NormalizeStyle(style);
+    int length = (int)strlen(text);
+    unsigned long long key = HashTextBlock(text, length, &style);
+    MeasureMemo* memo = FindMeasureMemo(key, length);
+    if (memo) {
+        memo->text = text;
+        STAT_ADD(measureHits, 1);
+        return memo;
+    }
+    STAT_ADD(measureMisses, 1);
+
+    for (int i = 0; i < MAX_MEASURE_MEMOS; i++) {
+        MeasureMemo* m = &g_ctx.memos[i];
+        if (!m->active) { memo = m; break; }
+        if (!memo || m->lastUsed < memo->lastUsed) memo = m;
+    }
+    if (!memo->active) g_ctx.memoCount++;
+    memo->active = false;
+
+    LayoutRichText(&memo->layout, text, style, false, NULL);
+    AdvTextLayout* layout = &memo->layout;
+    if (!ReserveArray((void**)&memo->lineWidths, &memo->lineWidthCapacity, layout->lineCount, sizeof(float))) {
+        g_ctx.memoCount--;
+        return NULL;
+    }
+    for (int i = 0; i < layout->lineCount; i++) memo->lineWidths[i] = layout->lines[i].width;
+
+    memo->key = key;
+    memo->textLength = length;
+    memo->text = text;
+    memo->lastUsed = g_ctx.frame;
+    memo->active = true;
+    return memo;
+}
+
+// 繪製時查詢備忘：先比對原文指標，沒有量測過這個指標的文字不計算雜湊；
+// 指標相同時再以長度與雜湊確認內容沒有改變 (同一個緩衝區可能已寫入別的文字)
+static MeasureMemo* FindMeasureMemoForDraw(const char* text, AdvTextStyle* style)
+{
+    bool measured = false;
+    for (int i = 0; i < MAX_MEASURE_MEMOS && !measured; i++) {
+        measured = g_ctx.memos[i].active && g_ctx.memos[i].text == text;
+    }
+    if (!measured) return NULL;
+
+    *style = NormalizeStyle(*style);
+    int length = (int)strlen(text);
+    return FindMeasureMemo(HashTextBlock(text, length, style), length);
+}
+
+// 清除所有量測備忘 (新增字型後備援結果可能改變；release 為 true 時一併釋放陣列)
+static void ClearMeasureMemos(bool release)
+{
+    for (int i = 0; i < MAX_MEASURE_MEMOS; i++) {
+        MeasureMemo* memo = &g_ctx.memos[i];
+        memo->active = false;
+        if (release) {
+            ClearLayout(&memo->layout);
+            MemFree(memo->lineWidths);
+            memset(memo, 0, sizeof(*memo));
+        }
+    }
+    g_ctx.memoCount = 0;
+}
+
+// 點擊測試：依 y 找出行，再在行內的斷行項目中二分搜尋 x 所在的字 (以前進寬度為範圍)
+static int HitTestLayout(const AdvTextLayout* layout, Vector2 point)
+{
+    if (layout->lineCount <= 0 || point.y < 0.0f || point.y >= layout->height) return -1;
+
+    int l = (int)(point.y / layout->lineHeight);
+    if (l >= layout->lineCount) l = layout->lineCount - 1;
+    while (l > 0 && layout->lines[l].y > point.y) l--;
+    while (l + 1 < layout->lineCount && layout->lines[l + 1].y <= point.y) l++;
+
+    const AdvLayoutLine* line = &layout->lines[l];
+    if (line->glyphCount <= 0) return -1;
+    const AdvLayoutItem* items = &layout->items[line->firstItem];
+    float x = point.x - GetAlignOffset(&layout->style, line->width);
+    if (x < 0.0f) return -1;
+    long long pen = items[0].penX + TO_LAYOUT_UNITS(x);
+
+    if (layout->itemsUnordered) {
+        // 筆位置不是遞增的 (字形可能重疊)：取最後一個範圍包含 x 的字
+        for (int j = line->glyphCount - 1; j >= 0; j--) {
+            if (items[j].penX <= pen && pen < items[j].penX + items[j].advance) return items[j].textOffset;
+        }
+        return -1;
+    }
+
+    int lo = 0, hi = line->glyphCount - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (items[mid].penX <= pen) lo = mid;
+        else hi = mid - 1;
+    }
+    return (pen < items[lo].penX + items[lo].advance) ? items[lo].textOffset : -1;
+}
+
+// -------------------------------------------------------------------------
+// 打字機 (AdvTypewriter)：建立時算好每個字的顯示時間，每幀更新只推進索引
+// -------------------------------------------------------------------------
+
+// 句讀標點：顯示後多停頓 punctuationDelay
+static bool IsPausePunctuation(int cp)
+{
+    switch (cp) {
+        case ',': case '.': case ';': case ':': case '!': case '?':
+        case 0x3001: case 0x3002: // 、。
+        case 0xFF0C: case 0xFF1B: case 0xFF1A: case 0xFF01: case 0xFF1F: // ，；：！？
+        case 0x2026: case 0x2014: // …—
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 依排版結果建立顯示時間表：每個字間隔 1 / speed，加上前面的停頓標籤與上一個字的標點停頓
+// runs 為排版時解析出的片段 (停頓記在片段開頭，套用到片段中的第一個字)
+static bool BuildRevealSteps(AdvTypewriter* tw, const char* text, const TextRunList* runs)
+{
+    const AdvTextLayout* layout = &tw->layout;
+    int count = layout->glyphCount;
+    if (count > 0) {
+        tw->steps = (AdvRevealStep*)MemAlloc((unsigned int)(count * sizeof(AdvRevealStep)));
+        if (!tw->steps) return false;
+    }
+
+    float interval = (tw->config.speed > 0.0f) ? 1.0f / tw->config.speed : 0.0f;
+    float t = 0.0f;
+    int run = 0, prevCp = 0, line = 0;
+    for (int i = 0; i < count; i++) {
+        AdvRevealStep* step = &tw->steps[i];
+        int offset = layout->glyphs[i].textOffset;
+        while (line + 1 < layout->lineCount && layout->lines[line + 1].firstGlyph <= i) line++;
+
+        t += interval;
+        for (; run < runs->count && runs->runs[run].start <= offset; run++) t += runs->runs[run].pause;
+        if (i > 0 && IsPausePunctuation(prevCp)) t += tw->config.punctuationDelay;
+
+        int bytes = 0;
+        step->codepoint = GetCodepointNext(&text[offset], &bytes);
+        step->revealTime = t;
+        step->textOffset = offset;
+        step->line = line;
+        prevCp = step->codepoint;
+    }
+
+    // 結尾的停頓標籤延後 isFinished (例如最後一句話後等一下才自動翻頁)
+    for (; run < runs->count; run++) t += runs->runs[run].pause;
+    tw->endTime = t;
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// 初始化輔助 (檔案映射、字型載入、快取重置)
+// -------------------------------------------------------------------------
+
+// 以唯讀方式映射檔案 (不支援 mmap 的平台改為整檔讀入)
+static bool MapFileReadOnly(const char* path, MappedFile* file)
+{
+    memset(file, 0, sizeof(*file));
+#if defined(ADVTEXT_MMAP)
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                file->data = (unsigned char*)p;
+                file->size = (size_t)st.st_size;
+                file->mapped = true;
+            }
+        }
+        close(fd); // 映射建立後即可關閉檔案描述子
+        if (file->mapped) return true;
+    }
+#endif
+    int size = 0;
+    file->data = LoadFileData(path, &size);
+    file->size = (size > 0) ? (size_t)size : 0;
+    return (file->data != NULL);
+}
+
+static void UnmapFile(MappedFile* file)
+{
+#if defined(ADVTEXT_MMAP)
+    if (file->mapped) munmap(file->data, file->size);
+    else UnloadFileData(file->data);
+#else
+    UnloadFileData(file->data);
+#endif
+    memset(file, 0, sizeof(*file));
+}
+
+// 映射字型檔並初始化 stb_truetype；faceIndex 選擇 TrueType 集合 (.ttc) 中的字型 (單一字型檔為 0)
+static bool LoadFontData(AdvFont* font, const char* fontPath, int faceIndex)
+{
+    if (!MapFileReadOnly(fontPath, &font->file)) {
+        TraceLog(LOG_WARNING, "AdvText: Failed to load font data from %s", fontPath);
+        return false;
+    }
+#if defined(ADVTEXT_MMAP)
+    // 只會讀到用過的字形輪廓：關閉預讀，未用到的頁不佔記憶體
+    if (font->file.mapped) posix_madvise(font->file.data, font->file.size, POSIX_MADV_RANDOM);
+#endif
+
+    int offset = (font->file.size >= 12) ? stbtt_GetFontOffsetForIndex(font->file.data, faceIndex) : -1;
+    if (offset < 0 || !stbtt_InitFont(&font->info, font->file.data, offset)) {
+        if (offset < 0) TraceLog(LOG_ERROR, "AdvText: Face %d not found in %s", faceIndex, fontPath);
+        else TraceLog(LOG_ERROR, "AdvText: Failed to init stbtt font");
+        UnmapFile(&font->file);
+        return false;
+    }
+
+    // 保留未縮放的度量，各字號的縮放與度量在 GetStrike 中換算
+    stbtt_GetFontVMetrics(&font->info, &font->ascent, &font->descent, &font->lineGap);
+    font->hasKerning = (font->info.kern != 0 || font->info.gpos != 0);
+    return true;
+}
+
+// 設定主字型 (字型 0)，並以初始字號建立 strike 0 (烘焙快取的字形也屬於它)
+static void SetPrimaryFont(int fontSize)
+{
+    AdvFont* font = &g_ctx.fonts[0];
+    strcpy(font->name, "default");
+    font->fallback = true; // 主字型永遠是備援鏈的第一順位
+    g_ctx.fontCount = 1;
+    g_ctx.fontSize = fontSize;
+
+    memset(g_ctx.strikes, 0, sizeof(g_ctx.strikes));
+    AdvStrike* st = &g_ctx.strikes[0];
+    st->font = 0;
+    st->size = fontSize;
+    st->epoch = ++g_ctx.strikeEpoch;
+    st->active = true;
+    if (font->file.data) {
+        st->scale = stbtt_ScaleForPixelHeight(&font->info, (float)fontSize);
+        st->ascent = (int)(font->ascent * st->scale);
+        st->descent = (int)(font->descent * st->scale);
+        st->lineGap = (int)(font->lineGap * st->scale);
+    }
+}
+
+// 清空字形快取與索引
+static void ResetGlyphCache(void)
+{
+    // 插槽版本保留並遞增：重新初始化前的排版結果不會誤用新的字形
+    for (int i = 0; i < MAX_GLYPHS; i++) {
+        unsigned int serial = g_ctx.cache[i].serial;
+        memset(&g_ctx.cache[i], 0, sizeof(AdvGlyph));
+        g_ctx.cache[i].serial = serial + 1;
+    }
+    ResetFreeSlots();
+    ResetGlyphLru();
+    ResetFreeCells();
+    ClearGlyphIndex();
+}
+
+// -------------------------------------------------------------------------
+// 公開 API 實作
+// -------------------------------------------------------------------------
+
+// 釋放目前上下文的所有資源 (上下文本身保留，可再次初始化)
+static void UnloadContext(void)
+{
+    if (g_ctx.loaded) {
+        StopRasterWorkers(); // 工作執行緒還在讀字型資料，先停止
+        for (int p = 0; p < g_ctx.pageCount; p++) {
+            if (g_ctx.pages[p].texture.id > 0) UnloadTexture(g_ctx.pages[p].texture);
+            MemFree(g_ctx.pages[p].pixels);
+            g_ctx.pages[p].pixels = NULL;
+        }
+        g_ctx.pageCount = 0;
+        MemFree(g_ctx.uploadBuffer);
+        g_ctx.uploadBuffer = NULL;
+        FreeRasterArena(&g_ctx.rasterArena);
+        for (int i = 0; i < g_ctx.fontCount; i++) UnmapFile(&g_ctx.fonts[i].file);
+        memset(g_ctx.fonts, 0, sizeof(g_ctx.fonts));
+        g_ctx.fontCount = 0;
+        memset(g_ctx.fontMemo, 0, sizeof(g_ctx.fontMemo));
+        g_ctx.fontMemoCount = 0;
+        memset(g_ctx.kernMemo, 0, sizeof(g_ctx.kernMemo));
+        g_ctx.kernMemoCount = 0;
+        memset(g_ctx.strikes, 0, sizeof(g_ctx.strikes));
+        ClearGlyphIndex();
+        MemFree(g_ctx.indexPages);
+        g_ctx.indexPages = NULL;
+        g_ctx.indexPageCapacity = 0;
+        ClearLayout(&g_ctx.scratch);
+        MemFree(g_ctx.runs.runs);
+        memset(&g_ctx.runs, 0, sizeof(g_ctx.runs));
+        FreeAdvTextDrawList(&g_ctx.drawList);
+        for (int i = 0; i < MAX_TEXT_BLOCKS; i++) UnloadTextBlock(&g_ctx.blocks[i]);
+        g_ctx.blockBytes = 0;
+        ClearMeasureMemos(true);
+        UnloadSDFShader();
+#if defined(ADVTEXT_ENABLE_STATS)
+        memset(&g_ctx.statFrame, 0, sizeof(g_ctx.statFrame));
+        memset(&g_ctx.statLastFrame, 0, sizeof(g_ctx.statLastFrame));
+        memset(&g_ctx.statTotal, 0, sizeof(g_ctx.statTotal));
+#endif
+#if defined(ADVTEXT_THREADS)
+        if (g_ctx.lockReady) pthread_rwlock_destroy(&g_ctx.cacheLock);
+#endif
+        g_ctx.lockReady = false;
+        g_ctx.loaded = false;
+        TraceLog(LOG_INFO, "AdvText: Unloaded");
+    }
+}
+
+// 初始化完成：建立標籤字典與快取鎖 (之後才能從背景執行緒排版)
+static void MarkContextLoaded(void)
+{
+    if (!g_ctx.dictReady) BuildTagDictionary();
+#if defined(ADVTEXT_THREADS)
+    if (!g_ctx.lockReady) g_ctx.lockReady = (pthread_rwlock_init(&g_ctx.cacheLock, NULL) == 0);
+#endif
+    g_ctx.loaded = true;
+}
+
+// 以字型檔初始化目前的上下文
+static void InitContext(const char* fontPath, int fontSize, unsigned int flags)
+{
+    if (g_ctx.loaded) UnloadContext(); // 防止重複初始化
+
+    g_ctx.flags = flags;
+    if (!LoadFontData(&g_ctx.fonts[0], fontPath, FLAG_FACE_INDEX(flags))) return;
+
+    // 計算字型度量
+    SetPrimaryFont(fontSize);
+
+    // 建立第一頁紋理圖集 (其餘頁需要時才建立)
+    g_ctx.pageCount = 0;
+    CreateAtlasPage(NULL, 0);
+
+    ResetGlyphCache();
+
+    MarkContextLoaded();
+    TraceLog(LOG_INFO, "AdvText: Initialized with font %s face %d size %d (Atlas: %dx%d, up to %d pages%s%s)", fontPath, FLAG_FACE_INDEX(flags), fontSize,
+             ATLAS_SIZE, ATLAS_SIZE, MAX_ATLAS_PAGES, (flags & ADVTEXT_FLAG_HEADLESS) ? ", headless" : "", g_ctx.fonts[0].file.mapped ? ", mapped" : "");
+}
+
+// 以烘焙快取檔初始化目前的上下文
+static bool InitContextFromCache(const char* cachePath, const char* fontPath)
+{
+    if (g_ctx.loaded) UnloadContext(); // 防止重複初始化
+
+    g_ctx.flags = 0;
+    MappedFile file = { 0 };
+    if (!MapFileReadOnly(cachePath, &file)) {
+        TraceLog(LOG_WARNING, "AdvText: Failed to open glyph cache %s", cachePath);
+        return false;
+    }
+
+    // 檢查檔頭與各區段大小
+    const CacheFileHeader* header = (const CacheFileHeader*)file.data;
+    if (file.size < sizeof(CacheFileHeader) || memcmp(header->magic, CACHE_FILE_MAGIC, 4) != 0 ||
+        header->version != CACHE_FILE_VERSION || header->atlasSize != ATLAS_SIZE ||
+        header->pageCount < 0 || header->pageCount > MAX_ATLAS_PAGES ||
+        header->glyphCount < 0 || header->glyphCount > MAX_GLYPHS || header->faceIndex < 0) {
+        TraceLog(LOG_WARNING, "AdvText: Glyph cache %s is invalid or was baked with different settings", cachePath);
+        UnmapFile(&file);
+        return false;
+    }
+
+    size_t offset = sizeof(CacheFileHeader);
+    const CacheFileGlyph* glyphs = (const CacheFileGlyph*)(file.data + offset);
+    offset += (size_t)header->glyphCount * sizeof(CacheFileGlyph);
+    const int* pageRows = (const int*)(file.data + offset);
+    offset += (size_t)header->pageCount * sizeof(int);
+
+    size_t pixelBytes = 0;
+    for (int p = 0; offset <= file.size && p < header->pageCount; p++) {
+        if (pageRows[p] < 0 || pageRows[p] > ATLAS_SIZE) { pixelBytes = file.size; break; }
+        pixelBytes += (size_t)pageRows[p] * ATLAS_SIZE;
+    }
+    if (offset > file.size || pixelBytes > file.size - offset) {
+        TraceLog(LOG_WARNING, "AdvText: Glyph cache %s is truncated", cachePath);
+        UnmapFile(&file);
+        return false;
+    }
+
+    // 每個字形的區域都必須落在所屬頁已烘焙的列中 (之後 LRU 回收會把新點陣寫進這些區域)
+    for (int i = 0; i < header->glyphCount; i++) {
+        const CacheFileGlyph* src = &glyphs[i];
+        bool blank = (src->w == 0 || src->h == 0);
+        bool valid = src->codepoint >= 0 && src->codepoint < 0x110000 && src->x >= 0 && src->y >= 0 && src->w >= 0 && src->h >= 0 &&
+                     (blank ? src->page == 0 : (src->page >= 0 && src->page < header->pageCount));
+        if (valid && !blank) valid = (src->x + src->w <= ATLAS_SIZE && src->y + src->h <= pageRows[src->page]);
+        if (!valid) {
+            TraceLog(LOG_WARNING, "AdvText: Glyph cache %s is corrupt (glyph %d U+%04X outside its atlas page)", cachePath, i, src->codepoint);
+            UnmapFile(&file);
+            return false;
+        }
+    }
+
+    // 字型是選擇性的：沒有字型時只能顯示烘焙過的字 (提供時使用烘焙時的集合索引)
+    if (fontPath && !LoadFontData(&g_ctx.fonts[0], fontPath, header->faceIndex)) {
+        UnmapFile(&file);
+        return false;
+    }
+    SetPrimaryFont(header->fontSize);
+    g_ctx.strikes[0].ascent = header->ascent;
+    g_ctx.strikes[0].descent = header->descent;
+    g_ctx.strikes[0].lineGap = header->lineGap;
+
+    // 圖集頁直接由烘焙像素建立 (第一次繪製時整塊上傳)
+    g_ctx.pageCount = 0;
+    const unsigned char* pixels = file.data + offset;
+    for (int p = 0; p < header->pageCount; p++) {
+        CreateAtlasPage(pixels, pageRows[p]);
+        pixels += (size_t)pageRows[p] * ATLAS_SIZE;
+    }
+    if (g_ctx.pageCount == 0) CreateAtlasPage(NULL, 0);
+
+    ResetGlyphCache();
+    for (int i = 0; i < header->glyphCount; i++) {
+        const CacheFileGlyph* src = &glyphs[i];
+        AdvGlyph* g = &g_ctx.cache[i];
+        g->key = MAKE_GLYPH_KEY(0, src->codepoint, GLYPH_VARIANT_BITMAP);
+        g->cell = (Rectangle){ src->x, src->y, src->w, src->h };
+        g->srcRec = g->cell;
+        g->page = (src->w == 0 || src->h == 0) ? 0 : src->page;
+        g->bearingX = src->bearingX;
+        g->bearingY = src->bearingY;
+        g->advance = src->advance;
+        g->glyphIndex = src->glyphIndex;
+        g->ready = true;
+        g->active = true;
+        LruPushBack(i);
+    }
+
+    // 索引每個字只需兩次陣列寫入，載入時直接建立 (不存在檔案中)
+    for (int i = 0; i < header->glyphCount; i++) GlyphIndexInsert(g_ctx.cache[i].key, i);
+    ResetFreeSlots();
+
+    TraceLog(LOG_INFO, "AdvText: Initialized from glyph cache %s (%d glyphs, %d pages, size %d%s)",
+             cachePath, header->glyphCount, g_ctx.pageCount, header->fontSize, g_ctx.fonts[0].file.data ? "" : ", no fallback font");
+    UnmapFile(&file);
+
+    MarkContextLoaded();
+    return true;
+}
+
+void InitAdvText(const char* fontPath, int fontSize)
+{
+    InitAdvTextEx(fontPath, fontSize, 0);
+}
+
+void InitAdvTextEx(const char* fontPath, int fontSize, unsigned int flags)
+{
+    AdvTextContext* prev = BindContext(&g_defaultCtx);
+    InitContext(fontPath, fontSize, flags);
+    BindContext(prev);
+}
+
+bool InitAdvTextFromCache(const char* cachePath, const char* fontPath)
+{
+    AdvTextContext* prev = BindContext(&g_defaultCtx);
+    bool ok = InitContextFromCache(cachePath, fontPath);
+    BindContext(prev);
+    return ok;
+}
+
+AdvTextContext* CreateAdvTextContext(const char* fontPath, int fontSize, unsigned int flags)
+{
+    AdvTextContext* ctx = (AdvTextContext*)MemAlloc(sizeof(AdvTextContext));
+    if (!ctx) return NULL;
+
+    AdvTextContext* prev = BindContext(ctx);
+    InitContext(fontPath, fontSize, flags);
+    bool ok = g_ctx.loaded;
+    BindContext(prev);
+
+    if (!ok) {
+        MemFree(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+AdvTextContext* CreateAdvTextContextFromCache(const char* cachePath, const char* fontPath)
+{
+    AdvTextContext* ctx = (AdvTextContext*)MemAlloc(sizeof(AdvTextContext));
+    if (!ctx) return NULL;
+
+    AdvTextContext* prev = BindContext(ctx);
+    bool ok = InitContextFromCache(cachePath, fontPath);
+    BindContext(prev);
+
+    if (!ok) {
+        MemFree(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+void DestroyAdvTextContext(AdvTextContext* ctx)
+{
+    if (!ctx) return;
+
+    AdvTextContext* prev = BindContext(ctx);
+    UnloadContext();
+    BindContext(prev);
+
+    // 預設上下文是靜態的，只釋放資源
+    if (ctx != &g_defaultCtx) MemFree(ctx);
+}
+
+AdvTextContext* GetAdvTextDefaultContext(void)
+{
+    return &g_defaultCtx;
+}
+
+bool BakeAdvTextCache(const char* fontPath, int fontSize, const char* charset, const char* outFile)
+{
+    return BakeAdvTextCacheEx(fontPath, 0, fontSize, charset, outFile);
+}
+
+bool BakeAdvTextCacheEx(const char* fontPath, int faceIndex, int fontSize, const char* charset, const char* outFile)
+{
+    if (!fontPath || !charset || !outFile) return false;
+
+    AdvFont font = { 0 };
+    if (!LoadFontData(&font, fontPath, faceIndex)) return false;
+    const stbtt_fontinfo* info = &font.info;
+
+    CacheFileHeader header = { 0 };
+    memcpy(header.magic, CACHE_FILE_MAGIC, 4);
+    header.version = CACHE_FILE_VERSION;
+    header.fontSize = fontSize;
+    header.atlasSize = ATLAS_SIZE;
+    header.faceIndex = faceIndex;
+
+    float scale = stbtt_ScaleForPixelHeight(info, (float)fontSize);
+    stbtt_GetFontVMetrics(info, &header.ascent, &header.descent, &header.lineGap);
+    header.ascent = (int)(header.ascent * scale);
+    header.descent = (int)(header.descent * scale);
+    header.lineGap = (int)(header.lineGap * scale);
+
+    // 烘焙不需要 GPU：只用 CPU 端的圖集頁與天際線打包
+    AtlasPage* pages = (AtlasPage*)MemAlloc(sizeof(AtlasPage) * MAX_ATLAS_PAGES);
+    CacheFileGlyph* glyphs = (CacheFileGlyph*)MemAlloc(sizeof(CacheFileGlyph) * MAX_GLYPHS);
+    unsigned char* seen = (unsigned char*)MemAlloc(0x110000 / 8); // 已烘焙的碼點 (位元表)
+    bool ok = (pages && glyphs && seen);
+    RasterArena arena = { 0 }; // stb_truetype 的暫存配置，每個字重置
+    RasterArena* prevArena = BindRasterArena(&arena);
+
+    int idx = 0;
+    while (ok && charset[idx]) {
+        int bytes = 0;
+        int cp = GetCodepointNext(&charset[idx], &bytes);
+        idx += bytes;
+        if (cp == '\n' || cp == '\r') continue;
+
+        // 略過重複的字
+        if (cp < 0 || cp >= 0x110000 || (seen[cp >> 3] & (1 << (cp & 7)))) continue;
+
+        if (header.glyphCount >= MAX_GLYPHS) {
+            TraceLog(LOG_WARNING, "AdvText: Bake charset exceeds MAX_GLYPHS (%d), remaining glyphs skipped", MAX_GLYPHS);
+            break;
+        }
+
+        int bw = 0, bh = 0, xoff = 0, yoff = 0, adv = 0;
+        int glyph = stbtt_FindGlyphIndex(info, cp);
+        unsigned char* bmp = stbtt_GetGlyphBitmap(info, scale, scale, glyph, &bw, &bh, &xoff, &yoff);
+        stbtt_GetGlyphHMetrics(info, glyph, &adv, NULL);
+        if (!bmp) bw = bh = 0;
+
+        // 打包到現有頁，放不下就開新頁
+        int page = 0, x = 0, y = 0;
+        bool placed = (bw == 0 || bh == 0);
+        for (page = 0; !placed && page < MAX_ATLAS_PAGES; page++) {
+            if (page == header.pageCount) {
+                pages[page].pixels = (unsigned char*)MemAlloc(ATLAS_SIZE * ATLAS_SIZE);
+                if (!pages[page].pixels) break;
+                pages[page].nodeCount = 0;
+                ResetAtlasPage(&pages[page]);
+                header.pageCount++;
+            }
+            if (SkylineAlloc(&pages[page], bw + ATLAS_PADDING, bh + ATLAS_PADDING, &x, &y)) {
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) {
+            TraceLog(LOG_WARNING, "AdvText: Bake atlas full (%d pages), remaining glyphs skipped", MAX_ATLAS_PAGES);
+            if (bmp) stbtt_FreeBitmap(bmp, NULL);
+            break;
+        }
+
+        CacheFileGlyph* g = &glyphs[header.glyphCount];
+        g->codepoint = cp;
+        g->x = (short)(x + ATLAS_PADDING / 2);
+        g->y = (short)(y + ATLAS_PADDING / 2);
+        g->w = (short)bw;
+        g->h = (short)bh;
+        g->bearingX = (short)xoff;
+        g->bearingY = (short)yoff;
+        g->advance = adv * scale;
+        g->glyphIndex = glyph;
+        g->page = (short)((bw == 0 || bh == 0) ? 0 : page);
+        if (bw > 0 && bh > 0) {
+            WriteGlyphPixels(&pages[page], (Rectangle){ g->x, g->y, bw, bh }, bmp, bw, bh, bw);
+        }
+        if (bmp) stbtt_FreeBitmap(bmp, NULL);
+        ResetRasterArena(&arena);
+
+        seen[cp >> 3] |= (unsigned char)(1 << (cp & 7));
+        header.glyphCount++;
+    }
+
+    // 寫檔：每頁只存天際線以上用到的列
+    FILE* fp = ok ? fopen(outFile, "wb") : NULL;
+    if (fp) {
+        int pageRows[MAX_ATLAS_PAGES] = { 0 };
+        for (int p = 0; p < header.pageCount; p++) {
+            for (int n = 0; n < pages[p].nodeCount; n++) {
+                if (pages[p].skyline[n].y > pageRows[p]) pageRows[p] = pages[p].skyline[n].y;
+            }
+        }
+        ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(glyphs, sizeof(CacheFileGlyph), header.glyphCount, fp) == (size_t)header.glyphCount &&
+             fwrite(pageRows, sizeof(int), header.pageCount, fp) == (size_t)header.pageCount;
+        for (int p = 0; ok && p < header.pageCount; p++) {
+            ok = fwrite(pages[p].pixels, ATLAS_SIZE, pageRows[p], fp) == (size_t)pageRows[p];
+        }
+        fclose(fp);
+    } else {
+        ok = false;
+    }
+
+    if (ok) TraceLog(LOG_INFO, "AdvText: Baked %d glyphs (%d pages) to %s", header.glyphCount, header.pageCount, outFile);
+    else TraceLog(LOG_WARNING, "AdvText: Failed to bake glyph cache to %s", outFile);
+
+    for (int p = 0; pages && p < header.pageCount; p++) MemFree(pages[p].pixels);
+    MemFree(pages);
+    MemFree(glyphs);
+    MemFree(seen);
+    BindRasterArena(prevArena);
+    FreeRasterArena(&arena);
+    UnmapFile(&font.file);
+    return ok;
+}
+
+int AddAdvTextFont(const char* fontPath, const char* name, bool fallback)
+{
+    return AddAdvTextFontExCtx(&g_defaultCtx, fontPath, 0, name, fallback);
+}
+
+int AddAdvTextFontEx(const char* fontPath, int faceIndex, const char* name, bool fallback)
+{
+    return AddAdvTextFontExCtx(&g_defaultCtx, fontPath, faceIndex, name, fallback);
+}
+
+// 註冊字型 (呼叫端已切換上下文並持有寫鎖)
+static int AddContextFont(const char* fontPath, int faceIndex, const char* name, bool fallback)
+{
+    if (!g_ctx.loaded || !fontPath || !name) return -1;
+    if (g_ctx.fontCount >= MAX_FONTS) {
+        TraceLog(LOG_WARNING, "AdvText: Too many fonts (MAX_FONTS %d), %s not added", MAX_FONTS, fontPath);
+        return -1;
+    }
+
+    // 新字型寫在尚未使用的位置，完成後才增加 fontCount (背景點陣化執行緒不會讀到一半的資料)
+    AdvFont* font = &g_ctx.fonts[g_ctx.fontCount];
+    memset(font, 0, sizeof(*font));
+    if (!LoadFontData(font, fontPath, faceIndex)) return -1;
+    strncpy(font->name, name, MAX_FONT_NAME - 1);
+    font->fallback = fallback;
+
+    // 備援鏈改變，先前的解析結果、量測備忘與已畫好的區塊作廢 (字距對以字型區分，不受影響)
+    // 區塊的紋理留在池中，之後的區塊沿用，不在這裡釋放
+    memset(g_ctx.fontMemo, 0, sizeof(g_ctx.fontMemo));
+    g_ctx.fontMemoCount = 0;
+    ClearMeasureMemos(false);
+    for (int i = 0; i < MAX_TEXT_BLOCKS; i++) g_ctx.blocks[i].active = false;
+
+    TraceLog(LOG_INFO, "AdvText: Font %d '%s' added from %s (face %d)%s", g_ctx.fontCount, font->name, fontPath, faceIndex, fallback ? " (fallback)" : "");
+    return g_ctx.fontCount++;
+}
+
+int AddAdvTextFontCtx(AdvTextContext* ctx, const char* fontPath, const char* name, bool fallback)
+{
+    return AddAdvTextFontExCtx(ctx, fontPath, 0, name, fallback);
+}
+
+int AddAdvTextFontExCtx(AdvTextContext* ctx, const char* fontPath, int faceIndex, const char* name, bool fallback)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    int font = AddContextFont(fontPath, faceIndex, name, fallback);
+    LeaveContext(prev);
+    return font;
+}
+
+void UnloadAdvText(void)
+{
+    DestroyAdvTextContext(&g_defaultCtx);
+}
+
+void BeginAdvTextFrame(void)
+{
+    BeginAdvTextFrameCtx(&g_defaultCtx);
+}
+
+void BeginAdvTextFrameCtx(AdvTextContext* ctx)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    g_ctx.frame++;
+    g_ctx.framesTracked = true;
+#if defined(ADVTEXT_ENABLE_STATS)
+    g_ctx.statLastFrame = g_ctx.statFrame;
+    memset(&g_ctx.statFrame, 0, sizeof(g_ctx.statFrame));
+#endif
+    ProcessRasterResults();
+    LeaveContext(prev);
+}
+
+// 缺少的字形排入背景點陣化，回傳是否排入 (佇列滿時 *full 設為 true)
+static bool PrefetchGlyphKey(unsigned int key, bool* full)
+{
+    if (GlyphIndexFind(key) != -1) return false;
 
-            AdvGlyph* g = GetGlyph(cp);
-            if (!g) { idx += bytes; continue; }
+    // 佇列滿了：剩下的字等下次預載或實際繪製時再處理，不在這裡卡住
+    if (g_ctx.workers.running && g_ctx.workers.inFlight >= MAX_RASTER_JOBS) {
+        *full = true;
+        return false;
+    }
 
-            Vector2 p = { drawX + g->bearingX, curY + g_ctx.ascent + g->bearingY };
+    AdvGlyph* g = CreateGlyph(key, true);
+    if (!g) return false;
+    if (QueueRasterJob(g)) return true;
+    RasterizeGlyph(g); // 沒有背景執行緒：直接點陣化
+    return false;
+}
 
-            // 繪製順序：陰影 -> 描邊 -> 本體
-            if (style.enableShadow) {
-                DrawTextureRec(g_ctx.atlas, g->srcRec, (Vector2){p.x + style.shadowOffset.x, p.y + style.shadowOffset.y}, style.shadowColor);
-            }
+// 預載文字在指定字號與變體下的字形 (outlineRadius > 0 時連同描邊字形)
+static int PrefetchTextGlyphs(const char* text, int size, int variant, int outlineRadius)
+{
+    StartRasterWorkers();
+
+    int queued = 0, run = 0, idx = 0, cp = 0;
+    unsigned int key = 0;
+    bool full = false;
+    TokenizeRichText(&g_ctx.runs, text, WHITE);
+    while (!full && NextTextGlyph(&g_ctx.runs, text, &run, &idx, &cp, &key, size, variant)) {
+        if (cp == '\n') continue;
+        queued += PrefetchGlyphKey(key, &full);
+        if (outlineRadius > 0 && !full) {
+            queued += PrefetchGlyphKey(MAKE_OUTLINE_KEY(GLYPH_KEY_STRIKE(key), cp, outlineRadius), &full);
+        }
+    }
+    return queued;
+}
+
+// 文字在指定字號與變體下的字形是否都已可繪製
+static bool TextGlyphsReady(const char* text, int size, int variant, int outlineRadius)
+{
+    ProcessRasterResults();
+
+    int run = 0, idx = 0, cp = 0;
+    unsigned int key = 0;
+    TokenizeRichText(&g_ctx.runs, text, WHITE);
+    while (NextTextGlyph(&g_ctx.runs, text, &run, &idx, &cp, &key, size, variant)) {
+        if (IsGlyphPending(key)) return false;
+        if (outlineRadius > 0 && IsGlyphPending(MAKE_OUTLINE_KEY(GLYPH_KEY_STRIKE(key), cp, outlineRadius))) return false;
+    }
+    return true;
+}
+
+int PrefetchAdvText(const char* text)
+{
+    return PrefetchAdvTextCtx(&g_defaultCtx, text);
+}
+
+int PrefetchAdvTextCtx(AdvTextContext* ctx, const char* text)
+{
+    int queued = 0;
+    AdvTextContext* prev = EnterContext(ctx);
+    if (g_ctx.loaded && text) queued = PrefetchTextGlyphs(text, g_ctx.fontSize, GLYPH_VARIANT_BITMAP, 0);
+    LeaveContext(prev);
+    return queued;
+}
+
+int PrefetchAdvTextStyled(const char* text, AdvTextStyle style)
+{
+    return PrefetchAdvTextStyledCtx(&g_defaultCtx, text, style);
+}
+
+int PrefetchAdvTextStyledCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style)
+{
+    int queued = 0;
+    AdvTextContext* prev = EnterContext(ctx);
+    if (g_ctx.loaded && text) {
+        style = NormalizeStyle(style);
+        int size, variant, outlineRadius;
+        GetStyleGlyphParams(&style, &size, &variant, &outlineRadius);
+        queued = PrefetchTextGlyphs(text, size, variant, outlineRadius);
+    }
+    LeaveContext(prev);
+    return queued;
+}
+
+bool IsAdvTextReady(const char* text)
+{
+    return IsAdvTextReadyCtx(&g_defaultCtx, text);
+}
+
+bool IsAdvTextReadyCtx(AdvTextContext* ctx, const char* text)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    bool ready = (g_ctx.loaded && text) && TextGlyphsReady(text, g_ctx.fontSize, GLYPH_VARIANT_BITMAP, 0);
+    LeaveContext(prev);
+    return ready;
+}
+
+bool IsAdvTextReadyStyled(const char* text, AdvTextStyle style)
+{
+    return IsAdvTextReadyStyledCtx(&g_defaultCtx, text, style);
+}
+
+bool IsAdvTextReadyStyledCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    bool ready = (g_ctx.loaded && text);
+    if (ready) {
+        style = NormalizeStyle(style);
+        int size, variant, outlineRadius;
+        GetStyleGlyphParams(&style, &size, &variant, &outlineRadius);
+        ready = TextGlyphsReady(text, size, variant, outlineRadius);
+    }
+    LeaveContext(prev);
+    return ready;
+}
+
+// 核心繪製函數 (立即模式：每次呼叫都重新排版，結果存在可重複使用的暫存排版中)
+void DrawRichTextStyled(const char* text, Vector2 pos, int charLimit, AdvTextStyle style)
+{
+    DrawRichTextStyledCtx(&g_defaultCtx, text, pos, charLimit, style);
+}
+
+void DrawRichTextStyledCtx(AdvTextContext* ctx, const char* text, Vector2 pos, int charLimit, AdvTextStyle style)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    if (g_ctx.loaded && text) {
+        // 先前量測過的文字直接沿用備忘中的排版 (只有原文指標量測過時才計算雜湊)
+        MeasureMemo* memo = (g_ctx.memoCount > 0) ? FindMeasureMemoForDraw(text, &style) : NULL;
+        if (memo) STAT_ADD(measureHits, 1);
+        if (memo) {
+            DrawLayout(&memo->layout, pos, charLimit);
+        } else {
+            LayoutRichText(&g_ctx.scratch, text, style, false, NULL);
+            DrawLayout(&g_ctx.scratch, pos, charLimit);
+        }
+    }
+    LeaveContext(prev);
+}
+
+AdvTextMetrics MeasureRichText(const char* text, AdvTextStyle style)
+{
+    return MeasureRichTextCtx(&g_defaultCtx, text, style);
+}
+
+AdvTextMetrics MeasureRichTextCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style)
+{
+    AdvTextMetrics metrics = { 0 };
+    AdvTextContext* prev = EnterContext(ctx);
+    MeasureMemo* memo = (g_ctx.loaded && text) ? AcquireMeasureMemo(text, style) : NULL;
+    if (memo) {
+        const AdvTextLayout* layout = &memo->layout;
+        metrics.bounds = (Rectangle){ GetAlignOffset(&layout->style, layout->width), 0.0f, layout->width, layout->height };
+        metrics.lineCount = layout->lineCount;
+        metrics.lineWidths = memo->lineWidths;
+    }
+    LeaveContext(prev);
+    return metrics;
+}
+
+int GetRichTextCharAtPoint(const char* text, AdvTextStyle style, Vector2 point)
+{
+    return GetRichTextCharAtPointCtx(&g_defaultCtx, text, style, point);
+}
+
+int GetRichTextCharAtPointCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style, Vector2 point)
+{
+    int offset = -1;
+    AdvTextContext* prev = EnterContext(ctx);
+    MeasureMemo* memo = (g_ctx.loaded && text) ? AcquireMeasureMemo(text, style) : NULL;
+    if (memo) offset = HitTestLayout(&memo->layout, point);
+    LeaveContext(prev);
+    return offset;
+}
+
+AdvTextLayout* BuildAdvTextLayout(const char* text, AdvTextStyle style)
+{
+    return BuildAdvTextLayoutCtx(&g_defaultCtx, text, style);
+}
+
+// 不取寫鎖：排版以讀鎖查詢快取，可在多個背景執行緒同時呼叫
+AdvTextLayout* BuildAdvTextLayoutCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style)
+{
+    AdvTextContext* prev = BindContext(ctx);
+    AdvTextLayout* layout = NULL;
+    if (g_ctx.loaded && text) {
+        layout = (AdvTextLayout*)MemAlloc(sizeof(AdvTextLayout));
+        if (layout) LayoutRichText(layout, text, style, true, NULL);
+    }
+    BindContext(prev);
+    return layout;
+}
+
+void DrawAdvTextLayout(AdvTextLayout* layout, Vector2 pos, int charLimit)
+{
+    if (!layout) return;
+
+    AdvTextContext* prev = EnterContext(layout->ctx);
+    if (g_ctx.loaded) DrawLayout(layout, pos, charLimit);
+    LeaveContext(prev);
+}
+
+// 只重新換行：沿用排版時記錄的斷行項目，不重新解析文字也不查詢快取
+void ReflowAdvTextLayout(AdvTextLayout* layout, float maxWidth)
+{
+    if (!layout) return;
+    layout->style.maxWidth = maxWidth;
+    WrapLayoutLines(layout, 0.0f);
+}
+
+void FreeAdvTextLayout(AdvTextLayout* layout)
+{
+    if (!layout) return;
+    ClearLayout(layout);
+    MemFree(layout);
+}
+
+void BuildAdvTextDrawList(AdvTextDrawList* list, AdvTextLayout* layout, Vector2 pos, int charLimit)
+{
+    if (!list) return;
+    list->count = 0;
+    if (!layout) return;
+
+    AdvTextContext* prev = EnterContext(layout->ctx);
+    if (g_ctx.loaded) {
+        STAT_ZONE_BEGIN(start, "AdvText Draw");
+        int glyphEnd = PrepareLayoutForDraw(layout, charLimit);
+        EmitLayoutQuads(list, layout, pos, glyphEnd);
+        list->ctx = layout->ctx;
+        STAT_ZONE_END(start, "AdvText Draw", drawNs);
+    }
+    LeaveContext(prev);
+}
 
-            if (style.enableOutline) {
-                float t = style.outlineThickness;
-                // 簡單的 4 向描邊，要求高可用 8 向
-                DrawTextureRec(g_ctx.atlas, g->srcRec, (Vector2){p.x - t, p.y}, style.outlineColor);
-                DrawTextureRec(g_ctx.atlas, g->srcRec, (Vector2){p.x + t, p.y}, style.outlineColor);
-                DrawTextureRec(g_ctx.atlas, g->srcRec, (Vector2){p.x, p.y - t}, style.outlineColor);
-                DrawTextureRec(g_ctx.atlas, g->srcRec, (Vector2){p.x, p.y + t}, style.outlineColor);
+void SubmitAdvTextDrawList(const AdvTextDrawList* list)
+{
+    if (!list) return;
+
+    AdvTextContext* prev = EnterContext(list->ctx);
+    if (g_ctx.loaded && !(g_ctx.flags & ADVTEXT_FLAG_HEADLESS)) {
+        STAT_ZONE_BEGIN(start, "AdvText Draw");
+        SubmitDrawQuads(list->quads, list->count);
+        STAT_ZONE_END(start, "AdvText Draw", drawNs);
+    }
+    LeaveContext(prev);
+}
+
+void FreeAdvTextDrawList(AdvTextDrawList* list)
+{
+    if (!list) return;
+    MemFree(list->quads);
+    list->quads = NULL;
+    list->count = list->capacity = 0;
+}
+
+AdvTextDocument* BuildAdvTextDocument(const char* text, AdvTextStyle style)
+{
+    return BuildAdvTextDocumentCtx(&g_defaultCtx, text, style);
+}
+
+AdvTextDocument* BuildAdvTextDocumentCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style)
+{
+    AdvTextDocument* doc = NULL;
+    AdvTextContext* prev = EnterContext(ctx);
+    if (g_ctx.loaded && text) {
+        doc = (AdvTextDocument*)MemAlloc(sizeof(AdvTextDocument));
+        int length = (int)strlen(text);
+        if (doc) doc->text = (char*)MemAlloc(length + 1);
+        if (doc && doc->text) {
+            memcpy(doc->text, text, length + 1);
+            if (!BuildDocumentIndex(doc, style)) {
+                FreeAdvTextDocument(doc);
+                doc = NULL;
             }
+        } else if (doc) {
+            MemFree(doc);
+            doc = NULL;
+        }
+    }
+    LeaveContext(prev);
+    return doc;
+}
+
+void DrawAdvTextDocument(AdvTextDocument* doc, Vector2 pos, Rectangle clip)
+{
+    if (!doc) return;
+
+    AdvTextContext* prev = EnterContext(doc->window.ctx);
+    if (g_ctx.loaded && doc->lineCount > 0) {
+        UpdateDocumentWindow(doc, clip.y - pos.y, clip.y + clip.height - pos.y);
+        if (doc->window.lineCount > 0) {
+            bool scissor = !(g_ctx.flags & ADVTEXT_FLAG_HEADLESS);
+            if (scissor) BeginScissorMode((int)clip.x, (int)clip.y, (int)clip.width, (int)clip.height);
+            DrawLayout(&doc->window, pos, -1);
+            if (scissor) EndScissorMode();
+        }
+    }
+    LeaveContext(prev);
+}
 
-            DrawTextureRec(g_ctx.atlas, g->srcRec, p, curColor);
+Vector2 GetAdvTextDocumentSize(const AdvTextDocument* doc)
+{
+    return doc ? (Vector2){ doc->width, doc->height } : (Vector2){ 0 };
+}
 
-            drawX += g->advance;
-            displayedChars++;
-            idx += bytes;
+int GetAdvTextDocumentLineCount(const AdvTextDocument* doc)
+{
+    return doc ? doc->lineCount : 0;
+}
+
+void FreeAdvTextDocument(AdvTextDocument* doc)
+{
+    if (!doc) return;
+    ClearLayout(&doc->window);
+    MemFree(doc->lines);
+    MemFree(doc->text);
+    MemFree(doc);
+}
+
+AdvTextStream* CreateAdvTextStream(AdvTextStyle style, int maxLines, int maxGlyphBytes)
+{
+    return CreateAdvTextStreamCtx(&g_defaultCtx, style, maxLines, maxGlyphBytes);
+}
+
+AdvTextStream* CreateAdvTextStreamCtx(AdvTextContext* ctx, AdvTextStyle style, int maxLines, int maxGlyphBytes)
+{
+    AdvTextStream* stream = NULL;
+    AdvTextContext* prev = EnterContext(ctx);
+    if (g_ctx.loaded) {
+        if (maxLines <= 0) maxLines = STREAM_DEFAULT_LINES;
+        int glyphCapacity = (maxGlyphBytes > 0) ? maxGlyphBytes / (int)sizeof(AdvLayoutGlyph) : maxLines * STREAM_GLYPHS_PER_LINE;
+        if (glyphCapacity < 1) glyphCapacity = 1;
+
+        stream = (AdvTextStream*)MemAlloc(sizeof(AdvTextStream));
+        if (stream) {
+            stream->lines = (AdvStreamLine*)MemAlloc(maxLines * sizeof(AdvStreamLine));
+            stream->glyphs = (AdvLayoutGlyph*)MemAlloc(glyphCapacity * sizeof(AdvLayoutGlyph));
+        }
+        if (stream && stream->lines && stream->glyphs) {
+            stream->ctx = g_current;
+            stream->maxLines = maxLines;
+            stream->glyphCapacity = glyphCapacity;
+
+            // 空白訊息取得行高與正規化後的樣式 (之後每次追加都沿用)
+            LayoutRichText(&stream->scratch, " ", style, false, NULL);
+            AdvTextLayout* scratch = &stream->scratch;
+            stream->lineHeight = (scratch->lineCount > 0) ? scratch->height / scratch->lineCount : scratch->style.fontSize;
+            stream->window.style = scratch->style;
+            stream->window.glyphScale = scratch->glyphScale;
+            stream->window.outlineRadius = scratch->outlineRadius;
+            stream->window.ctx = g_current;
+            for (int f = 0; f < MAX_FONTS; f++) stream->strikes.strike[f] = -1;
+            stream->serial = 1;
+        } else {
+            FreeAdvTextStream(stream);
+            stream = NULL;
+        }
+    }
+    LeaveContext(prev);
+    return stream;
+}
+
+void AppendAdvText(AdvTextStream* stream, const char* text)
+{
+    if (!stream || !text) return;
+
+    AdvTextContext* prev = EnterContext(stream->ctx);
+    if (g_ctx.loaded) {
+        AdvTextLayout* scratch = &stream->scratch;
+        LayoutRichText(scratch, text, scratch->style, false, NULL);
+        RebindStreamStrikes(stream); // 環中的字形鍵與新訊息使用同一組 strike
+        for (int i = 0; i < scratch->lineCount; i++) PushStreamLine(stream, scratch, &scratch->lines[i]);
+        for (int f = 0; f < MAX_FONTS; f++) {
+            if (scratch->strikes.strike[f] < 0) continue;
+            stream->strikes.strike[f] = scratch->strikes.strike[f];
+            stream->strikes.epoch[f] = scratch->strikes.epoch[f];
+        }
+        stream->strikes.size = scratch->strikes.size;
+        stream->strikeMask |= scratch->strikeMask;
+        stream->serial++;
+    }
+    LeaveContext(prev);
+}
+
+void DrawAdvTextStream(AdvTextStream* stream, Rectangle bounds, float scroll)
+{
+    if (!stream) return;
+
+    AdvTextContext* prev = EnterContext(stream->ctx);
+    if (g_ctx.loaded && stream->lineCount > 0 && stream->lineHeight > 0.0f) {
+        if (scroll < 0.0f) scroll = 0.0f;
+        RebindStreamStrikes(stream);
+        UpdateStreamWindow(stream, bounds.height, scroll);
+
+        const AdvTextStyle* style = &stream->window.style;
+        Vector2 anchor = { bounds.x, bounds.y + bounds.height + scroll };
+        if (style->align == TEXT_ALIGN_CENTER) anchor.x += bounds.width / 2.0f;
+        else if (style->align == TEXT_ALIGN_RIGHT) anchor.x += bounds.width;
+
+        bool scissor = !(g_ctx.flags & ADVTEXT_FLAG_HEADLESS);
+        if (scissor) BeginScissorMode((int)bounds.x, (int)bounds.y, (int)bounds.width, (int)bounds.height);
+        DrawLayout(&stream->window, anchor, -1);
+        if (scissor) EndScissorMode();
+    }
+    LeaveContext(prev);
+}
+
+int GetAdvTextStreamLineCount(const AdvTextStream* stream)
+{
+    return stream ? stream->lineCount : 0;
+}
+
+float GetAdvTextStreamHeight(const AdvTextStream* stream)
+{
+    return stream ? stream->lineCount * stream->lineHeight : 0.0f;
+}
+
+void ClearAdvTextStream(AdvTextStream* stream)
+{
+    if (!stream) return;
+    stream->oldest = stream->lineCount = 0;
+    stream->glyphStart = stream->glyphCount = 0;
+    stream->strikeMask = 0;
+    for (int f = 0; f < MAX_FONTS; f++) stream->strikes.strike[f] = -1;
+    stream->serial++;
+}
+
+void FreeAdvTextStream(AdvTextStream* stream)
+{
+    if (!stream) return;
+    ClearLayout(&stream->scratch);
+    ClearLayout(&stream->window);
+    MemFree(stream->lines);
+    MemFree(stream->glyphs);
+    MemFree(stream);
+}
+
+void DrawRichTextCached(const char* text, Vector2 pos, AdvTextStyle style)
+{
+    DrawRichTextCachedCtx(&g_defaultCtx, text, pos, style);
+}
+
+void DrawRichTextCachedCtx(AdvTextContext* ctx, const char* text, Vector2 pos, AdvTextStyle style)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    if (g_ctx.loaded && text) {
+        style = NormalizeStyle(style);
+        int length = (int)strlen(text);
+        unsigned long long key = HashTextBlock(text, length, &style);
+        TextBlock* block = FindTextBlock(key, length);
+        AdvTextLayout* layout = &g_ctx.scratch;
+        if (block) {
+            STAT_ADD(blockHits, 1);
+            block->lastUsed = g_ctx.frame;
+        } else {
+            STAT_ADD(blockMisses, 1);
+            // 量測備忘與區塊使用相同的鍵：量測過的文字不需再排版
+            MeasureMemo* memo = (g_ctx.memoCount > 0) ? FindMeasureMemo(key, length) : NULL;
+            if (memo) STAT_ADD(measureHits, 1);
+            else LayoutRichText(&g_ctx.scratch, text, style, false, NULL);
+            layout = memo ? &memo->layout : &g_ctx.scratch;
+            if (!(g_ctx.flags & ADVTEXT_FLAG_HEADLESS)) block = RenderTextBlock(layout, key, length);
         }
-        
-        // 處理這行剩下的標籤 (避免顏色沒切回來影響下一行，或是索引沒跟上)
-        // 簡單來說，如果因為 charLimit 提早跳出，idx 會停在中間，下個 frame 會繼續
-        // 但如果這行畫完了，idx 應該要等於 scan (除非有換行符)
-        if (idx < scan) idx = scan; 
 
-        // 如果是因為強制換行跳出的，要吃掉那個換行符
-        if (forcedNewline) {
-             // 確保下次迴圈從換行後開始
+        if (block) DrawTextBlock(block, pos);
+        else DrawLayout(layout, pos, -1);
+    }
+    LeaveContext(prev);
+}
+
+void SetAdvTextBlockCacheBudget(int bytes)
+{
+    SetAdvTextBlockCacheBudgetCtx(&g_defaultCtx, bytes);
+}
+
+void SetAdvTextBlockCacheBudgetCtx(AdvTextContext* ctx, int bytes)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    g_ctx.blockBudget = (bytes > 0) ? bytes : 0;
+    TrimTextBlocks((bytes > 0) ? bytes : TEXT_BLOCK_BUDGET);
+    LeaveContext(prev);
+}
+
+void ClearAdvTextBlockCache(void)
+{
+    ClearAdvTextBlockCacheCtx(&g_defaultCtx);
+}
+
+void ClearAdvTextBlockCacheCtx(AdvTextContext* ctx)
+{
+    AdvTextContext* prev = EnterContext(ctx);
+    for (int i = 0; i < MAX_TEXT_BLOCKS; i++) UnloadTextBlock(&g_ctx.blocks[i]);
+    LeaveContext(prev);
+}
+
+Texture2D GetAdvTextAtlas(int page)
+{
+    return GetAdvTextAtlasCtx(&g_defaultCtx, page);
+}
+
+Texture2D GetAdvTextAtlasCtx(AdvTextContext* ctx, int page)
+{
+    if (!ctx) ctx = &g_defaultCtx;
+    if (!ctx->loaded || page < 0 || page >= ctx->pageCount) return (Texture2D){ 0 };
+    return ctx->pages[page].texture;
+}
+
+AdvTextStats GetAdvTextStats(void)
+{
+    return GetAdvTextStatsCtx(&g_defaultCtx);
+}
+
+AdvTextStats GetAdvTextStatsCtx(AdvTextContext* ctx)
+{
+    AdvTextStats stats = { 0 };
+    AdvTextContext* prev = EnterContext(ctx);
+    if (g_ctx.loaded) {
+#if defined(ADVTEXT_ENABLE_STATS)
+        stats.frame = g_ctx.statLastFrame;
+        stats.total = g_ctx.statTotal;
+#endif
+        for (int i = 0; i < MAX_GLYPHS; i++) {
+            if (g_ctx.cache[i].active) stats.glyphCount++;
         }
 
-        curY += lineHeight;
+        // 填充率：已配置面積 / 全部頁面；碎片率：天際線以下沒被用到的比例 (打包留下的空隙)
+        double used = 0.0, covered = 0.0;
+        for (int p = 0; p < g_ctx.pageCount; p++) {
+            const AtlasPage* page = &g_ctx.pages[p];
+            used += page->usedArea;
+            for (int n = 0; n < page->nodeCount; n++) covered += (double)page->skyline[n].width * page->skyline[n].y;
+        }
+        for (int i = 0; i < MAX_TEXT_BLOCKS; i++) {
+            if (g_ctx.blocks[i].active) stats.blockCount++;
+        }
+        stats.blockBytes = g_ctx.blockBytes;
+        stats.atlasPages = g_ctx.pageCount;
+        if (g_ctx.pageCount > 0) stats.atlasOccupancy = (float)(used / ((double)g_ctx.pageCount * ATLAS_SIZE * ATLAS_SIZE));
+        if (covered > 0.0) stats.atlasFragmentation = (float)(1.0 - used / covered);
     }
+    LeaveContext(prev);
+    return stats;
+}
+
+void SetAdvTextProfilerHooks(AdvTextZoneCallback begin, AdvTextZoneCallback end, void* userData)
+{
+#if defined(ADVTEXT_ENABLE_STATS)
+    g_profiler.begin = begin;
+    g_profiler.end = end;
+    g_profiler.userData = userData;
+#else
+    (void)begin; (void)end; (void)userData;
+#endif
 }
 
 void UpdateTypewriter(Typewriter* tw, const char* text, float delta) {
+    UpdateTypewriterCtx(&g_defaultCtx, tw, text, delta);
+}
+
+void UpdateTypewriterCtx(AdvTextContext* ctx, Typewriter* tw, const char* text, float delta) {
     if (tw->isFinished) return;
     
     tw->elapsed += delta;
     int targetChars = (int)(tw->elapsed * tw->speed);
     
-    // 計算實際的可見字元總數
-    int visibleLen = 0;
-    int i = 0;
-    
-    // 預先計算總長度，判斷是否結束
-    // 這裡其實可以優化，不用每幀重算總長，但為了 API 簡單先這樣做
-    int tempIdx = 0;
+    // 只數碼點 (不解析字型與字號，不改動快取)；這一幀新顯示的字才查詢是否還在背景點陣化
+    // 舊 API 沒有地方保存排版結果，每幀仍要掃描整段文字，新程式請改用 AdvTypewriter
+    // 片段放在區域變數，只需讀鎖 (與 BuildAdvTextLayoutCtx 相同，可與背景排版同時進行)
+    // 舊 API 不知道繪製的字號：等待只比對初始化字號的點陣字形，其他字號或 SDF 不會停下來等
+    int run = 0, tempIdx = 0, cp = 0, bytes = 0;
     int totalVisible = 0;
-    while(text[tempIdx]) {
-        if (text[tempIdx] == '[') {
-            if (strncmp(&text[tempIdx], "[/color]", 8) == 0) { tempIdx += 8; continue; }
-            if (strncmp(&text[tempIdx], "[color=", 7) == 0) {
-                char* end = strchr(&text[tempIdx + 7], ']');
-                if (end) { tempIdx = (int)(end - text) + 1; continue; }
-            }
-        }
-        int bytes;
-        int cp = GetCodepointNext(&text[tempIdx], &bytes);
-        if (cp != '\n') totalVisible++;
+    int firstPending = -1; // 第一個還在背景點陣化的可見字元
+    AdvTextContext* prev = BindContext(ctx);
+    LockContext(false);
+    TextRunList runs = { 0 };
+    TokenizeRichText(&runs, text, WHITE);
+    const TextRun* tr = NULL;
+    while ((tr = PeekRunCodepoint(&runs, text, &run, &tempIdx, &cp, &bytes)) != NULL) {
         tempIdx += bytes;
+        if (cp == '\n') continue;
+        if (firstPending < 0 && totalVisible >= tw->currentChars && totalVisible < targetChars && g_ctx.loaded) {
+            int font = FindGlyphFont(tr->font, cp);
+            int strike = (font >= 0) ? FindStrike(font, g_ctx.fontSize) : -1;
+            if (strike >= 0 && IsGlyphPending(MAKE_GLYPH_KEY(strike, cp, GLYPH_VARIANT_BITMAP))) firstPending = totalVisible;
+        }
+        totalVisible++;
+    }
+    UnlockContext();
+    BindContext(prev);
+    MemFree(runs.runs);
+
+    // 下一個字還沒準備好：打字機停在這裡等它
+    if (firstPending >= 0) {
+        targetChars = firstPending;
+        if (tw->speed > 0) tw->elapsed = firstPending / tw->speed;
     }
 
     if (targetChars > totalVisible) targetChars = totalVisible;
     tw->currentChars = targetChars;
     tw->isFinished = (tw->currentChars >= totalVisible);
-}
\ No newline at end of file
+}
+
+AdvTypewriter* CreateAdvTypewriter(const char* text, AdvTextStyle style, AdvTypewriterConfig config)
+{
+    return CreateAdvTypewriterCtx(&g_defaultCtx, text, style, config);
+}
+
+// 與 BuildAdvTextLayoutCtx 相同，可在背景執行緒建立
+AdvTypewriter* CreateAdvTypewriterCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style, AdvTypewriterConfig config)
+{
+    AdvTextContext* prev = BindContext(ctx);
+    AdvTypewriter* tw = NULL;
+    if (g_ctx.loaded && text) tw = (AdvTypewriter*)MemAlloc(sizeof(AdvTypewriter));
+    if (tw) {
+        tw->config = config;
+        LayoutRichText(&tw->layout, text, style, true, NULL);
+        if (!BuildRevealSteps(tw, text, &tw->layout.runs)) { // 沿用排版剛解析的片段
+            FreeAdvTypewriter(tw);
+            tw = NULL;
+        }
+    }
+    BindContext(prev);
+
+    if (tw && config.speed <= 0.0f) SkipAdvTypewriter(tw);
+    return tw;
+}
+
+void UpdateAdvTypewriter(AdvTypewriter* tw, float delta)
+{
+    if (!tw || tw->isFinished) return;
+
+    tw->elapsed += delta;
+
+    // 背景點陣化完成的字形寫入圖集，這次會顯示的字重新取得字形狀態 (只查詢插槽已變更的字)
+    // 第一個還在背景點陣化的字停住打字機；沒有插槽或點陣化失敗的字 (例如比圖集還大) 與 DrawLayout 一樣當作空白顯示
+    int stall = tw->layout.glyphCount;
+    AdvTextContext* prev = EnterContext(tw->layout.ctx);
+    ProcessRasterResults();
+    RebindLayoutStrikes(&tw->layout);
+    for (int i = tw->visible; i < tw->layout.glyphCount && tw->elapsed >= tw->steps[i].revealTime; i++) {
+        RevalidateLayoutGlyph(&tw->layout, &tw->layout.glyphs[i]);
+        if (IsLayoutGlyphPending(&tw->layout.glyphs[i])) {
+            stall = i;
+            break;
+        }
+    }
+    LeaveContext(prev);
+
+    // 只往前推進：每個字在整段顯示過程中只被跨過一次
+    while (tw->visible < tw->layout.glyphCount && tw->elapsed >= tw->steps[tw->visible].revealTime) {
+        // 下一個字還在背景點陣化：停在這裡等它 (時間不累積，就緒後不會一次跳出多個字)
+        if (tw->visible == stall) {
+            tw->elapsed = tw->steps[tw->visible].revealTime;
+            return;
+        }
+        const AdvRevealStep* step = &tw->steps[tw->visible];
+        if (tw->config.onReveal) tw->config.onReveal(tw->visible, step->codepoint, tw->config.userData);
+        tw->visible++;
+    }
+
+    tw->isFinished = (tw->visible >= tw->layout.glyphCount && tw->elapsed >= tw->endTime);
+}
+
+void DrawAdvTypewriter(AdvTypewriter* tw, Vector2 pos)
+{
+    if (!tw) return;
+
+    AdvTextContext* prev = EnterContext(tw->layout.ctx);
+    if (g_ctx.loaded) DrawLayout(&tw->layout, pos, tw->visible);
+    LeaveContext(prev);
+}
+
+void SkipAdvTypewriter(AdvTypewriter* tw)
+{
+    if (!tw) return;
+    tw->visible = tw->layout.glyphCount;
+    if (tw->elapsed < tw->endTime) tw->elapsed = tw->endTime;
+    tw->isFinished = true;
+}
+
+bool IsAdvTypewriterFinished(const AdvTypewriter* tw)
+{
+    return !tw || tw->isFinished;
+}
+
+int GetAdvTypewriterVisibleCount(const AdvTypewriter* tw)
+{
+    return tw ? tw->visible : 0;
+}
+
+int GetAdvTypewriterLine(const AdvTypewriter* tw)
+{
+    if (!tw || tw->visible == 0) return 0;
+    return tw->steps[tw->visible - 1].line;
+}
+
+int GetAdvTypewriterTextOffset(const AdvTypewriter* tw)
+{
+    if (!tw || tw->visible == 0) return 0;
+    const AdvRevealStep* step = &tw->steps[tw->visible - 1];
+    int bytes = 0;
+    CodepointToUTF8(step->codepoint, &bytes);
+    return step->textOffset + bytes;
+}
+
+void FreeAdvTypewriter(AdvTypewriter* tw)
+{
+    if (!tw) return;
+    ClearLayout(&tw->layout);
+    MemFree(tw->steps);
+    MemFree(tw);
+}
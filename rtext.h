@@ -15,7 +15,7 @@ typedef enum {
     TEXT_ALIGN_RIGHT
 } AdvTextAlign;
 
-// 打字機結構（控制顯示速度與進度）
+// 打字機結構（控制顯示速度與進度；每幀重新掃描整段文字，新程式建議使用 AdvTypewriter）
 typedef struct {
     float speed;        // 每秒顯示字元數
     float elapsed;      // 累積時間
@@ -46,8 +46,59 @@ typedef struct {
     bool enableOutline;          // 是否啟用描邊
     Color outlineColor;          // 描邊顏色
     float outlineThickness;      // 描邊厚度（預設1.0f）
+
+    // 字號與 SDF
+    bool enableSDF;              // 使用距離場字形（任意字號共用一份圖集，陰影與描邊一次繪製；需要字型檔）
+    float fontSize;              // 繪製字號（0為初始化時的字號；點陣模式取整數像素，每種字號各自快取）
 } AdvTextStyle;
 
+// 文字系統上下文（不透明型別：各自擁有字型、字形快取與圖集，例如 UI 字型與場景名牌字型分開管理）
+// 不帶上下文的函數使用預設上下文（InitAdvText 初始化的那一個）
+typedef struct AdvTextContext AdvTextContext;
+
+// 保留模式排版結果（不透明型別：解析與排版一次，之後每幀只需繪製）
+typedef struct AdvTextLayout AdvTextLayout;
+
+// 長文件（不透明型別：建立時排版一次並記下每行的起點，之後每幀只排版與繪製可見的行）
+typedef struct AdvTextDocument AdvTextDocument;
+
+// 串流文字（不透明型別：聊天或戰鬥紀錄，只追加；新訊息只排版自己的行，舊行超過上限時被擠出）
+typedef struct AdvTextStream AdvTextStream;
+
+// 打字機物件（不透明型別：建立時排版並算好每個字的顯示時間，每幀更新為常數時間）
+typedef struct AdvTypewriter AdvTypewriter;
+
+// 新字顯示時的回呼（index 為第幾個字，可用來播放對話音效）
+typedef void (*AdvTypewriterCallback)(int index, int codepoint, void* userData);
+
+// 打字機設定
+typedef struct {
+    float speed;                    // 每秒顯示字元數（0 以下為立即全部顯示）
+    float punctuationDelay;         // 句讀標點（，。！？… 等）之後的額外停頓秒數
+    AdvTypewriterCallback onReveal; // 每顯示一個新字呼叫一次（可為 NULL）
+    void* userData;                 // 傳給回呼的使用者資料
+} AdvTypewriterConfig;
+
+// 繪製清單中的一個四邊形（可交給自訂的繪製後端）
+typedef struct {
+    Rectangle dest;     // 螢幕上的位置與大小
+    Rectangle uv;       // 圖集中的 UV 範圍（0~1）
+    Color color;        // 顏色（已套用顏色標籤、陰影或描邊色）
+    int page;           // 圖集頁（以 GetAdvTextAtlas 取得紋理）
+} AdvTextQuad;
+
+// 繪製清單（依圖層排列，每層內依圖集頁分組；以 {0} 初始化，重複使用其容量）
+typedef struct {
+    AdvTextQuad* quads; // 四邊形陣列
+    int count;          // 四邊形數
+    int capacity;       // 已配置的容量
+    AdvTextContext* ctx; // 建立清單的上下文（提交時取得其圖集；由 BuildAdvTextDrawList 設定）
+} AdvTextDrawList;
+
+// 初始化旗標（InitAdvTextEx）
+#define ADVTEXT_FLAG_HEADLESS 0x1 // 不建立 GPU 紋理也不繪製，只排版與點陣化（無視窗的測試或工具）
+#define ADVTEXT_FLAG_FACE(index) (((unsigned int)(index) & 0xFF) << 8) // 主字型在 TrueType 集合（.ttc）中的索引（預設 0）
+
 // -------------------------------------------------------------------------
 // 函數宣告
 // -------------------------------------------------------------------------
@@ -55,13 +106,241 @@ typedef struct {
 // 初始化模組（載入字型，設定大小）
 void InitAdvText(const char* fontPath, int fontSize);
 
+// 初始化模組並指定旗標（ADVTEXT_FLAG_*；例如 ADVTEXT_FLAG_FACE(1) 使用集合中的第二個字型）
+// 字型檔以唯讀方式映射（mmap），只有用到的表與字形輪廓會讀入記憶體
+void InitAdvTextEx(const char* fontPath, int fontSize, unsigned int flags);
+
+// 從烘焙快取檔初始化（檔案以 mmap 映射，圖集每頁一次上傳）
+// fontPath 可為 NULL：此時只能顯示烘焙過的字；提供字型時，未烘焙的字照常點陣化
+bool InitAdvTextFromCache(const char* cachePath, const char* fontPath);
+
+// 離線烘焙字形快取檔（不需要視窗或 GPU）：charset 為 UTF-8 字串，重複的字會略過
+bool BakeAdvTextCache(const char* fontPath, int fontSize, const char* charset, const char* outFile);
+
+// 從 TrueType 集合（.ttc）中的指定字型烘焙；集合索引存在快取檔中，InitAdvTextFromCache 載入字型時使用同一個字型
+bool BakeAdvTextCacheEx(const char* fontPath, int faceIndex, int fontSize, const char* charset, const char* outFile);
+
+// 註冊額外字型（粗體、標題或缺字備援），回傳字型編號，失敗回傳 -1
+// name 用於 [font=name] 標籤；fallback 為 true 時加入備援鏈，其他字型缺字時依註冊順序嘗試
+int AddAdvTextFont(const char* fontPath, const char* name, bool fallback);
+
+// 註冊 TrueType 集合（.ttc，例如 msjh.ttc）中的字型，faceIndex 從 0 開始；其餘同 AddAdvTextFont
+int AddAdvTextFontEx(const char* fontPath, int faceIndex, const char* name, bool fallback);
+
 // 釋放資源
 void UnloadAdvText(void);
 
+// 每幀開始時呼叫一次：上一幀用過的字形才能在快取滿時被回收（LRU）
+// 未呼叫時所有字形都視為本幀使用中，快取滿時會退回整個清空（Flush）
+void BeginAdvTextFrame(void);
+
+// 預載文字中的字形：缺少的字形交給背景執行緒點陣化，回傳排入背景的字數
+// 字形就緒前繪製時會先留白，UpdateTypewriter 也會停在尚未就緒的字等待（僅限初始化字號）
+int PrefetchAdvText(const char* text);
+
+// 文字中的字形是否都已可繪製（可用來決定何時切換到預載好的下一句）
+bool IsAdvTextReady(const char* text);
+
+// 依繪製時的樣式預載：字號（fontSize）、SDF 與點陣描邊字形都與 DrawRichTextStyled 取得的相同
+// 不帶樣式的版本只預載初始化字號的點陣字形
+int PrefetchAdvTextStyled(const char* text, AdvTextStyle style);
+bool IsAdvTextReadyStyled(const char* text, AdvTextStyle style);
+
 // 繪製富文本（核心函數：支援顏色標籤、樣式、字元限制）
 void DrawRichTextStyled(const char* text, Vector2 pos, int charLimit, AdvTextStyle style);
 
-// 更新打字機狀態（計算目前應顯示字元數，忽略標籤）
+// 量測結果（位置相對於繪製原點，與 DrawRichTextStyled 的 pos 相同）
+typedef struct {
+    Rectangle bounds;           // 包圍盒（依對齊方式：置中為 -寬/2，靠右為 -寬；不含背景內距）
+    int lineCount;              // 行數
+    const float* lineWidths;    // 每行寬度（指向內部備忘，之後量測其他文字可能失效，需要保留請自行複製）
+} AdvTextMetrics;
+
+// 量測富文本（換行與對齊同 DrawRichTextStyled）；排版結果留在小型備忘中，
+// 同一段文字與樣式之後的量測、點擊測試與 DrawRichTextStyled / DrawRichTextCached 不再重新排版
+AdvTextMetrics MeasureRichText(const char* text, AdvTextStyle style);
+
+// 點擊測試：point 相對於繪製原點，回傳該處的字在原文中的位元組位置（不在任何字上回傳 -1）
+int GetRichTextCharAtPoint(const char* text, AdvTextStyle style, Vector2 point);
+
+// 建立排版結果（解析標籤、換行、對齊只做一次；文字或樣式改變時需重新建立）
+AdvTextLayout* BuildAdvTextLayout(const char* text, AdvTextStyle style);
+
+// 繪製排版結果（charLimit 意義同 DrawRichTextStyled，-1 為全部）
+void DrawAdvTextLayout(AdvTextLayout* layout, Vector2 pos, int charLimit);
+
+// 以新的最大寬度重新換行（視窗縮放、介面動畫）；斷行機會與字寬在建立時已算好，只重新分行與對齊
+// maxWidth <= 0 為不自動換行；不取鎖，不可與同一個排版的繪製同時呼叫
+void ReflowAdvTextLayout(AdvTextLayout* layout, float maxWidth);
+
+// 釋放排版結果
+void FreeAdvTextLayout(AdvTextLayout* layout);
+
+// 把排版結果轉成四邊形清單（不含背景框；無 GPU 模式下也可使用）
+// SDF 模式只輸出本體四邊形，陰影與描邊需要 DrawAdvTextLayout 的內建著色器
+void BuildAdvTextDrawList(AdvTextDrawList* list, AdvTextLayout* layout, Vector2 pos, int charLimit);
+
+// 以 rlgl 提交繪製清單（同一圖集頁的四邊形在同一批次中送出）
+void SubmitAdvTextDrawList(const AdvTextDrawList* list);
+
+// 釋放繪製清單的陣列
+void FreeAdvTextDrawList(AdvTextDrawList* list);
+
+// 建立長文件（複製一份文字並建立行索引；日誌、圖鑑、小說等長篇捲動文字使用）
+AdvTextDocument* BuildAdvTextDocument(const char* text, AdvTextStyle style);
+
+// 繪製長文件與 clip（螢幕座標）相交的行，並以 clip 做剪裁；捲動時移動 pos.y 即可
+void DrawAdvTextDocument(AdvTextDocument* doc, Vector2 pos, Rectangle clip);
+
+// 整份文件的尺寸（捲軸使用）與行數
+Vector2 GetAdvTextDocumentSize(const AdvTextDocument* doc);
+int GetAdvTextDocumentLineCount(const AdvTextDocument* doc);
+
+// 釋放長文件
+void FreeAdvTextDocument(AdvTextDocument* doc);
+
+// 建立串流文字：最多保留 maxLines 行，字形環最多佔用 maxGlyphBytes 位元組（0 使用預設值；建立時一次配置）
+// maxGlyphBytes 只是字形環的大小：行環（maxLines 行）與排版暫存（隨最長的訊息成長）另外配置
+AdvTextStream* CreateAdvTextStream(AdvTextStyle style, int maxLines, int maxGlyphBytes);
+
+// 追加一則訊息（從新的一行開始，標籤不會延續到下一則；成本只與訊息長度有關）
+void AppendAdvText(AdvTextStream* stream, const char* text);
+
+// 繪製串流：最新一行貼齊 bounds 底端往上排，並以 bounds 剪裁；scroll 為往回捲動的像素（0 為最新）
+void DrawAdvTextStream(AdvTextStream* stream, Rectangle bounds, float scroll);
+
+// 保留的行數與總高度（捲軸使用）
+int GetAdvTextStreamLineCount(const AdvTextStream* stream);
+float GetAdvTextStreamHeight(const AdvTextStream* stream);
+
+// 清除所有訊息 / 釋放串流
+void ClearAdvTextStream(AdvTextStream* stream);
+void FreeAdvTextStream(AdvTextStream* stream);
+
+// 以區塊快取繪製不常改變的文字（選單、提示、HUD、打完字的對話）：第一次把整個區塊畫進渲染紋理，
+// 之後同樣的文字與樣式每幀只畫一個四邊形；不能在 BeginTextureMode 或 BeginMode2D 之中呼叫
+void DrawRichTextCached(const char* text, Vector2 pos, AdvTextStyle style);
+
+// 設定區塊紋理的記憶體上限（位元組，0 為預設值；超過時依 LRU 回收）
+void SetAdvTextBlockCacheBudget(int bytes);
+
+// 清除所有快取的區塊並釋放紋理（AddAdvTextFont 會自動讓區塊作廢，不需另外呼叫）
+void ClearAdvTextBlockCache(void);
+
+// 取得圖集頁的紋理（自訂繪製後端使用；無 GPU 模式下 id 為 0）
+Texture2D GetAdvTextAtlas(int page);
+
+// 更新打字機狀態（計算目前應顯示字元數，忽略標籤；只在初始化字號的字形未就緒時停下等待）
 void UpdateTypewriter(Typewriter* tw, const char* text, float delta);
 
+// 建立打字機：排版並建立顯示時間表（文字中的 [pause=秒] 標籤會在該處停頓）
+// text 只在建立時讀取；文字或樣式改變時需重新建立
+AdvTypewriter* CreateAdvTypewriter(const char* text, AdvTextStyle style, AdvTypewriterConfig config);
+
+// 推進打字機（只處理本幀新出現的字；下一個字還在背景點陣化時會停下來等它）
+void UpdateAdvTypewriter(AdvTypewriter* tw, float delta);
+
+// 繪製打字機目前顯示的部分
+void DrawAdvTypewriter(AdvTypewriter* tw, Vector2 pos);
+
+// 立即顯示全部（不呼叫 onReveal）
+void SkipAdvTypewriter(AdvTypewriter* tw);
+
+// 是否已全部顯示（含結尾的停頓）
+bool IsAdvTypewriterFinished(const AdvTypewriter* tw);
+
+// 已顯示字數、最後一個已顯示字所在的行、已顯示部分在原文中的結尾位元組位置
+int GetAdvTypewriterVisibleCount(const AdvTypewriter* tw);
+int GetAdvTypewriterLine(const AdvTypewriter* tw);
+int GetAdvTypewriterTextOffset(const AdvTypewriter* tw);
+
+// 釋放打字機
+void FreeAdvTypewriter(AdvTypewriter* tw);
+
+// -------------------------------------------------------------------------
+// 執行統計（需以 ADVTEXT_ENABLE_STATS 編譯 rtext.c；未定義時計數全部為 0，也沒有任何額外成本）
+// -------------------------------------------------------------------------
+
+// 計數器（時間單位為奈秒）
+typedef struct {
+    unsigned int cacheHits;         // 字形快取命中
+    unsigned int cacheMisses;       // 未命中（新建立的字形）
+    unsigned int rasterizations;    // 點陣化的字形數（含背景執行緒完成的）
+    unsigned int evictions;         // LRU 回收的字形數
+    unsigned int flushes;           // 快取清空的次數 (含只清空沒有本幀字形的圖集頁)
+    unsigned long long uploadBytes; // 上傳到 GPU 的紋理位元組數
+    unsigned int quads;             // 送出的四邊形數
+    unsigned int drawCalls;         // 繪製批次數（每次換圖集頁一個）
+    unsigned int blockHits;         // DrawRichTextCached 命中已快取的區塊
+    unsigned int blockMisses;       // DrawRichTextCached 未命中（排版並畫進區塊紋理）
+    unsigned int measureHits;       // 量測、點擊測試與繪製命中量測備忘
+    unsigned int measureMisses;     // MeasureRichText / GetRichTextCharAtPoint 未命中（排版並存入備忘）
+    unsigned long long rasterizeNs; // 點陣化時間（背景執行緒的時間也計入）
+    unsigned long long layoutNs;    // 排版時間（含排版時缺字的同步點陣化）
+    unsigned long long drawNs;      // 繪製時間（含上傳圖集）
+} AdvTextCounters;
+
+// 統計快照
+typedef struct {
+    AdvTextCounters frame;          // 上一個完整的幀（兩次 BeginAdvTextFrame 之間）
+    AdvTextCounters total;          // 初始化以來的累計
+    int glyphCount;                 // 快取中的字形數
+    int atlasPages;                 // 已建立的圖集頁數
+    float atlasOccupancy;           // 填充率：已配置面積 / 所有頁面的面積
+    float atlasFragmentation;       // 碎片率：天際線以下沒被用到的面積比例
+    int blockCount;                 // 快取中的文字區塊數（DrawRichTextCached）
+    int blockBytes;                 // 區塊紋理佔用的位元組（含等待重用的紋理）
+} AdvTextStats;
+
+// 效能分析區段回呼（name 為 "AdvText Layout" 等固定字串；可能在背景執行緒呼叫）
+typedef void (*AdvTextZoneCallback)(const char* name, void* userData);
+
+// 取得統計（快照欄位在未啟用統計時也有效）
+AdvTextStats GetAdvTextStats(void);
+
+// 設定效能分析區段的開始/結束回呼（例如轉給 Tracy 的 zone；所有上下文共用，傳 NULL 取消）
+void SetAdvTextProfilerHooks(AdvTextZoneCallback begin, AdvTextZoneCallback end, void* userData);
+
+// -------------------------------------------------------------------------
+// 多上下文（AdvTextContext）
+// 排版結果、打字機與繪製清單記得建立它們的上下文，繪製、更新與釋放時不需再指定
+// 執行緒：BuildAdvTextLayoutCtx 與 CreateAdvTypewriterCtx 可在多個背景執行緒同時呼叫
+// （以讀鎖查詢字形快取，缺字時才短暫取寫鎖）；其餘函數與 GPU 上傳只在渲染執行緒呼叫
+// 建立、銷毀上下文與 AddAdvTextFontCtx 時不能有背景排版正在進行
+// -------------------------------------------------------------------------
+
+// 建立獨立的上下文（參數同 InitAdvTextEx），失敗回傳 NULL
+AdvTextContext* CreateAdvTextContext(const char* fontPath, int fontSize, unsigned int flags);
+
+// 從烘焙快取檔建立上下文（參數同 InitAdvTextFromCache），失敗回傳 NULL
+AdvTextContext* CreateAdvTextContextFromCache(const char* cachePath, const char* fontPath);
+
+// 銷毀上下文（傳入預設上下文時等同 UnloadAdvText）
+void DestroyAdvTextContext(AdvTextContext* ctx);
+
+// 取得預設上下文
+AdvTextContext* GetAdvTextDefaultContext(void);
+
+// 以下函數與不帶 Ctx 的版本相同，作用於指定的上下文（ctx 為 NULL 時使用預設上下文）
+int AddAdvTextFontCtx(AdvTextContext* ctx, const char* fontPath, const char* name, bool fallback);
+int AddAdvTextFontExCtx(AdvTextContext* ctx, const char* fontPath, int faceIndex, const char* name, bool fallback);
+void BeginAdvTextFrameCtx(AdvTextContext* ctx);
+int PrefetchAdvTextCtx(AdvTextContext* ctx, const char* text);
+bool IsAdvTextReadyCtx(AdvTextContext* ctx, const char* text);
+int PrefetchAdvTextStyledCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style);
+bool IsAdvTextReadyStyledCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style);
+void DrawRichTextStyledCtx(AdvTextContext* ctx, const char* text, Vector2 pos, int charLimit, AdvTextStyle style);
+AdvTextMetrics MeasureRichTextCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style);
+int GetRichTextCharAtPointCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style, Vector2 point);
+AdvTextLayout* BuildAdvTextLayoutCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style);
+AdvTextDocument* BuildAdvTextDocumentCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style);
+AdvTextStream* CreateAdvTextStreamCtx(AdvTextContext* ctx, AdvTextStyle style, int maxLines, int maxGlyphBytes);
+void DrawRichTextCachedCtx(AdvTextContext* ctx, const char* text, Vector2 pos, AdvTextStyle style);
+void SetAdvTextBlockCacheBudgetCtx(AdvTextContext* ctx, int bytes);
+void ClearAdvTextBlockCacheCtx(AdvTextContext* ctx);
+Texture2D GetAdvTextAtlasCtx(AdvTextContext* ctx, int page);
+AdvTextStats GetAdvTextStatsCtx(AdvTextContext* ctx);
+void UpdateTypewriterCtx(AdvTextContext* ctx, Typewriter* tw, const char* text, float delta);
+AdvTypewriter* CreateAdvTypewriterCtx(AdvTextContext* ctx, const char* text, AdvTextStyle style, AdvTypewriterConfig config);
+
 #endif // __R_TEXT_H__
\ No newline at end of file
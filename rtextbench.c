@@ -0,0 +1,1225 @@
+// rtext 效能基準測試：不需要視窗或 GPU，以固定語料量測字形快取、排版與打字機的熱路徑
+// 直接 #include "rtext.c"：配置函數與 GPU 呼叫換成計數用的替身，內部的 GetGlyph 也可以單獨量測
+//
+// 編譯：gcc -O2 rtextbench.c -o rtextbench -lraylib -lm -lpthread
+// 執行：./rtextbench [字型檔 (預設 assets/tpu.ttf)] [重複次數 (預設 3)] > result.csv
+// 輸出為 CSV (每個測試一行)，不同版本的結果可以直接 diff；警告訊息寫到 stderr
+// 部分測試同時檢查正確性 (例如圖集容量)，檢查失敗時寫到 stderr，結束碼為 2
+
+// clock_gettime 與 rtext.c 的 pthread_rwlock_t 在嚴格 C99 模式下需要 POSIX 宣告 (必須在任何標頭之前)
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+
+// -------------------------------------------------------------------------
+// 替身：計數配置 (MemAlloc 系列；stb_truetype 的暫存配置經由 rtext.c 的點陣化暫存區，也會計入)
+// -------------------------------------------------------------------------
+
+static long long g_allocCount;      // 配置次數
+static long long g_allocBytes;      // 配置的位元組數
+
+static void* BenchAlloc(unsigned int size)
+{
+    g_allocCount++;
+    g_allocBytes += size;
+    return calloc(size, 1); // 與 raylib 的 MemAlloc 相同，配置後清為 0
+}
+
+static void* BenchRealloc(void* ptr, unsigned int size)
+{
+    g_allocCount++;
+    g_allocBytes += size;
+    return realloc(ptr, size);
+}
+
+static void BenchFree(void* ptr)
+{
+    free(ptr);
+}
+
+#define MemAlloc BenchAlloc
+#define MemRealloc BenchRealloc
+#define MemFree BenchFree
+
+// 替身：空的繪製後端 (只記錄上傳量，其餘不做事)
+#define GenImageColor StubGenImageColor
+#define UnloadImage StubUnloadImage
+#define LoadTextureFromImage StubLoadTextureFromImage
+#define UnloadTexture StubUnloadTexture
+#define UpdateTextureRec StubUpdateTextureRec
+#define SetTextureFilter StubSetTextureFilter
+#define LoadShaderFromMemory StubLoadShaderFromMemory
+#define UnloadShader StubUnloadShader
+#define GetShaderLocation StubGetShaderLocation
+#define SetShaderValue StubSetShaderValue
+#define BeginShaderMode StubBeginShaderMode
+#define EndShaderMode StubEndShaderMode
+#define DrawRectangleRounded StubDrawRectangleRounded
+#define BeginScissorMode StubBeginScissorMode
+#define EndScissorMode StubEndScissorMode
+#define rlBegin StubRlBegin
+#define rlEnd StubRlEnd
+#define rlSetTexture StubRlSetTexture
+#define rlCheckRenderBatchLimit StubRlCheckRenderBatchLimit
+#define rlColor4ub StubRlColor4ub
+#define rlNormal3f StubRlNormal3f
+#define rlTexCoord2f StubRlTexCoord2f
+#define rlVertex2f StubRlVertex2f
+#define LoadRenderTexture StubLoadRenderTexture
+#define UnloadRenderTexture StubUnloadRenderTexture
+#define BeginTextureMode StubBeginTextureMode
+#define EndTextureMode StubEndTextureMode
+#define ClearBackground StubClearBackground
+#define BeginBlendMode StubBeginBlendMode
+#define EndBlendMode StubEndBlendMode
+#define DrawTextureRec StubDrawTextureRec
+#define rlSetBlendFactorsSeparate StubRlSetBlendFactorsSeparate
+
+#define ADVTEXT_ENABLE_STATS         // 快取命中、Flush 與上傳量取自 GetAdvTextStats
+#include "rtext.c"
+
+#include <stdarg.h>
+#include <time.h>
+#if defined(__linux__)
+    #include <unistd.h> // sysconf (RSS 以頁為單位)
+#endif
+
+static unsigned int g_textureId;
+
+Image GenImageColor(int width, int height, Color color) { (void)color; return (Image){ NULL, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 }; }
+void UnloadImage(Image image) { (void)image; }
+Texture2D LoadTextureFromImage(Image image) { return (Texture2D){ ++g_textureId, image.width, image.height, 1, image.format }; }
+void UnloadTexture(Texture2D texture) { (void)texture; }
+void UpdateTextureRec(Texture2D texture, Rectangle rec, const void* pixels) { (void)texture; (void)rec; (void)pixels; }
+void SetTextureFilter(Texture2D texture, int filter) { (void)texture; (void)filter; }
+Shader LoadShaderFromMemory(const char* vsCode, const char* fsCode) { (void)vsCode; (void)fsCode; return (Shader){ 1, NULL }; }
+void UnloadShader(Shader shader) { (void)shader; }
+int GetShaderLocation(Shader shader, const char* uniformName) { (void)shader; (void)uniformName; return 0; }
+void SetShaderValue(Shader shader, int locIndex, const void* value, int uniformType) { (void)shader; (void)locIndex; (void)value; (void)uniformType; }
+void BeginShaderMode(Shader shader) { (void)shader; }
+void EndShaderMode(void) { }
+void DrawRectangleRounded(Rectangle rec, float roundness, int segments, Color color) { (void)rec; (void)roundness; (void)segments; (void)color; }
+void BeginScissorMode(int x, int y, int width, int height) { (void)x; (void)y; (void)width; (void)height; }
+void EndScissorMode(void) { }
+void rlBegin(int mode) { (void)mode; }
+void rlEnd(void) { }
+void rlSetTexture(unsigned int id) { (void)id; }
+bool rlCheckRenderBatchLimit(int vCount) { (void)vCount; return false; }
+void rlColor4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a) { (void)r; (void)g; (void)b; (void)a; }
+void rlNormal3f(float x, float y, float z) { (void)x; (void)y; (void)z; }
+void rlTexCoord2f(float x, float y) { (void)x; (void)y; }
+void rlVertex2f(float x, float y) { (void)x; (void)y; }
+RenderTexture2D LoadRenderTexture(int width, int height) { return (RenderTexture2D){ ++g_textureId, { ++g_textureId, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 }, { 0 } }; }
+void UnloadRenderTexture(RenderTexture2D target) { (void)target; }
+void BeginTextureMode(RenderTexture2D target) { (void)target; }
+void EndTextureMode(void) { }
+void ClearBackground(Color color) { (void)color; }
+void BeginBlendMode(int mode) { (void)mode; }
+void EndBlendMode(void) { }
+void DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint) { (void)texture; (void)source; (void)position; (void)tint; }
+void rlSetBlendFactorsSeparate(int glSrcRGB, int glDstRGB, int glSrcAlpha, int glDstAlpha, int glEqRGB, int glEqAlpha)
+{
+    (void)glSrcRGB; (void)glDstRGB; (void)glSrcAlpha; (void)glDstAlpha; (void)glEqRGB; (void)glEqAlpha;
+}
+
+// -------------------------------------------------------------------------
+// 參數設定
+// -------------------------------------------------------------------------
+
+#define BENCH_FONT_SIZE 24
+#define BENCH_CORPUS_GLYPHS 20000   // 每份語料的可見字數 (ASCII、標籤、常用字語料與小說章節一致)
+#define BENCH_HANZI_COUNT 3500      // 常用字集大小
+#define BENCH_PAGE_BYTES 1200       // 一頁 (一幀繪製的對話框) 的最大位元組數，只在段落邊界切頁
+#define BENCH_WARM_PASSES 10        // GetGlyph 熱快取的重複次數
+#define BENCH_TYPEWRITER_SPEED 60.0f
+#define BENCH_FRAME_TIME (1.0f / 60.0f)
+#define BENCH_CACHED_FRAMES 30      // 區塊快取：每頁停留的幀數
+#define BENCH_KERN_PASSES 20       // 字距：每頁重新排版的次數 (字形與字距表都已熱身)
+#define BENCH_REFLOW_FRAMES 60      // 寬度動畫：每頁的幀數 (寬度在 320 到 640 之間來回)
+#define BENCH_SCROLL_STEP 8.0f      // 長文件每幀捲動的像素
+#define BENCH_STREAM_LINES 200      // 串流保留的行數
+#define BENCH_STREAM_PASSES 10      // 整份語料追加幾輪 (紀錄早已塞滿，量測穩定狀態)
+#define BENCH_TOKENIZE_PASSES 50    // 標籤解析：整份語料重複解析的次數
+#define BENCH_FUZZ_INPUTS 20000     // 標籤解析的亂數輸入數 (固定種子)
+#define BENCH_FUZZ_PIECES 48        // 每個亂數輸入最多由幾個片段組成
+#define BENCH_TITLE_SIZE 32         // 圖集打包：第二種字號 (常用字集在內文與標題兩種字號同時使用)
+#define BENCH_INDEX_BASE 0x4E00     // 字形索引：從 CJK 區塊開頭連續取碼點 (密集碼點是模數雜湊最差的情況)
+
+// -------------------------------------------------------------------------
+// 工具
+// -------------------------------------------------------------------------
+
+static double NowSeconds(void)
+{
+#if defined(_WIN32)
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// 目前的常駐記憶體 (RSS，含映射後實際讀入的字型頁)；無法取得時為 -1
+static long long ResidentBytes(void)
+{
+    long long pages = -1;
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        long long size = 0;
+        if (fscanf(f, "%lld %lld", &size, &pages) != 2) pages = -1;
+        fclose(f);
+    }
+    if (pages >= 0) pages *= sysconf(_SC_PAGESIZE);
+#endif
+    return pages;
+}
+
+// 固定種子的亂數 (各平台結果相同)
+static unsigned int g_seed;
+static unsigned int NextRandom(void)
+{
+    g_seed = g_seed * 1664525u + 1013904223u;
+    return g_seed >> 8;
+}
+
+// 正確性檢查：失敗時寫到 stderr 並記錄，main 以非零結束碼回報
+static int g_checkFailures;
+static void BenchCheck(bool ok, const char* bench, const char* corpus, const char* what)
+{
+    if (ok) return;
+    fprintf(stderr, "rtextbench: CHECK FAILED %s,%s: %s\n", bench, corpus, what);
+    g_checkFailures++;
+}
+
+static void BenchTraceLog(int logLevel, const char* text, va_list args)
+{
+    if (logLevel >= LOG_WARNING) {
+        vfprintf(stderr, text, args);
+        fputc('\n', stderr);
+    }
+}
+
+// 可增長的字串緩衝區
+typedef struct {
+    char* data;
+    int length, capacity;
+} TextBuffer;
+
+static void AppendText(TextBuffer* buf, const char* text)
+{
+    int len = (int)strlen(text);
+    if (!ReserveArray((void**)&buf->data, &buf->capacity, buf->length + len + 1, 1)) return;
+    memcpy(buf->data + buf->length, text, len + 1);
+    buf->length += len;
+}
+
+static void AppendCodepoint(TextBuffer* buf, int cp)
+{
+    int bytes = 0;
+    const char* utf8 = CodepointToUTF8(cp, &bytes);
+    char tmp[8] = { 0 };
+    memcpy(tmp, utf8, bytes);
+    AppendText(buf, tmp);
+}
+
+// -------------------------------------------------------------------------
+// 語料 (以固定種子產生，每次執行內容相同)
+// -------------------------------------------------------------------------
+
+static int g_hanzi[BENCH_HANZI_COUNT];  // 常用字集 (依出現頻率排序，第 0 個最常用)
+static float g_hanziCdf[BENCH_HANZI_COUNT];
+
+// 從 CJK 基本區取 BENCH_HANZI_COUNT 個不重複的字，頻率依 Zipf 分布 (第 r 名的權重為 1/r)
+// 沒有內建官方常用字表：字數與頻率分布相同，快取與圖集的負載特性一致
+static void BuildHanziSet(void)
+{
+    static unsigned char used[0x9FA6 - 0x4E00];
+    memset(used, 0, sizeof(used));
+    g_seed = 3500;
+    for (int i = 0; i < BENCH_HANZI_COUNT; ) {
+        int cp = 0x4E00 + (int)(NextRandom() % (0x9FA6 - 0x4E00));
+        if (used[cp - 0x4E00]) continue;
+        used[cp - 0x4E00] = 1;
+        g_hanzi[i++] = cp;
+    }
+
+    float sum = 0.0f;
+    for (int i = 0; i < BENCH_HANZI_COUNT; i++) sum += 1.0f / (i + 1);
+    float acc = 0.0f;
+    for (int i = 0; i < BENCH_HANZI_COUNT; i++) {
+        acc += 1.0f / (i + 1) / sum;
+        g_hanziCdf[i] = acc;
+    }
+}
+
+static int RandomHanzi(void)
+{
+    float u = (NextRandom() & 0xFFFFFF) / (float)0x1000000;
+    int lo = 0, hi = BENCH_HANZI_COUNT - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (g_hanziCdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return g_hanzi[lo];
+}
+
+// 英文段落 (單字隨機組成句子)
+static void BuildAsciiCorpus(TextBuffer* buf)
+{
+    static const char* words[] = {
+        "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "ancient", "ruins",
+        "hero", "walked", "into", "glyph", "cache", "atlas", "kerning", "AV", "To", "Wave",
+        "layout", "render", "text", "with", "of", "and", "a", "in", "dragon", "sword"
+    };
+    g_seed = 1;
+    int visible = 0, line = 0;
+    while (visible < BENCH_CORPUS_GLYPHS) {
+        const char* w = words[NextRandom() % (sizeof(words) / sizeof(words[0]))];
+        AppendText(buf, w);
+        visible += (int)strlen(w);
+        line += (int)strlen(w);
+        if (line > 200 && NextRandom() % 4 == 0) {
+            AppendText(buf, ".\n");
+            visible += 1;
+            line = 0;
+        } else {
+            AppendText(buf, (NextRandom() % 10 == 0) ? ", " : " ");
+            visible += 1;
+        }
+    }
+}
+
+// 標籤密集：每 1~4 個字就切換顏色，夾雜十六進位顏色、巢狀與停頓標籤 (每段結束前關閉所有標籤)
+static void BuildTagCorpus(TextBuffer* buf)
+{
+    static const char* colors[] = { "red", "gold", "skyblue", "lime", "#FF8800", "#20C0E0AA", "violet", "gray" };
+    g_seed = 2;
+    int visible = 0, depth = 0, paragraph = 0;
+    while (visible < BENCH_CORPUS_GLYPHS) {
+        unsigned int r = NextRandom() % 8;
+        if (r < 3 && depth < 3) {
+            char tag[32];
+            snprintf(tag, sizeof(tag), "[color=%s]", colors[NextRandom() % 8]);
+            AppendText(buf, tag);
+            depth++;
+        } else if (r < 5 && depth > 0) {
+            AppendText(buf, "[/color]");
+            depth--;
+        } else if (r == 5 && NextRandom() % 4 == 0) {
+            AppendText(buf, "[pause=0.2]");
+        }
+
+        int count = 1 + (int)(NextRandom() % 4);
+        for (int i = 0; i < count; i++) {
+            if (NextRandom() % 3 == 0) AppendCodepoint(buf, 'a' + (int)(NextRandom() % 26));
+            else AppendCodepoint(buf, RandomHanzi());
+        }
+        visible += count;
+        paragraph += count;
+
+        if (paragraph > 100) {
+            while (depth > 0) { AppendText(buf, "[/color]"); depth--; }
+            AppendText(buf, "\n");
+            paragraph = 0;
+        }
+    }
+    while (depth > 0) { AppendText(buf, "[/color]"); depth--; }
+}
+
+// 常用字：整個字集依序打亂後重複，每個字出現次數相同 (快取的最差分布)
+static void BuildHanziCorpus(TextBuffer* buf)
+{
+    int order[BENCH_HANZI_COUNT];
+    for (int i = 0; i < BENCH_HANZI_COUNT; i++) order[i] = g_hanzi[i];
+    g_seed = 3;
+    int visible = 0;
+    while (visible < BENCH_CORPUS_GLYPHS) {
+        for (int i = BENCH_HANZI_COUNT - 1; i > 0; i--) {
+            int j = (int)(NextRandom() % (i + 1));
+            int t = order[i]; order[i] = order[j]; order[j] = t;
+        }
+        for (int i = 0; i < BENCH_HANZI_COUNT && visible < BENCH_CORPUS_GLYPHS; i++) {
+            AppendCodepoint(buf, order[i]);
+            visible++;
+            if (visible % 40 == 0) AppendText(buf, "\n");
+        }
+    }
+}
+
+// 小說章節：Zipf 分布的用字、標點、對話引號與長短不一的段落
+static void BuildNovelCorpus(TextBuffer* buf)
+{
+    static const int punct[] = { 0xFF0C, 0xFF0C, 0xFF0C, 0x3002, 0x3002, 0xFF01, 0xFF1F, 0x3001, 0x2026 };
+    g_seed = 4;
+    int visible = 0, paragraph = 0, sentence = 0;
+    bool quote = false;
+    int target = 80 + (int)(NextRandom() % 120);
+    while (visible < BENCH_CORPUS_GLYPHS) {
+        if (paragraph == 0 && NextRandom() % 3 == 0) {
+            AppendCodepoint(buf, 0x300C); // 「
+            quote = true;
+            visible++;
+        }
+        AppendCodepoint(buf, RandomHanzi());
+        visible++;
+        paragraph++;
+        sentence++;
+
+        if (sentence > 6 && NextRandom() % 5 == 0) {
+            AppendCodepoint(buf, punct[NextRandom() % (sizeof(punct) / sizeof(punct[0]))]);
+            visible++;
+            sentence = 0;
+        }
+        if (paragraph >= target) {
+            if (quote) { AppendCodepoint(buf, 0x300D); visible++; quote = false; } // 」
+            AppendText(buf, "\n");
+            paragraph = 0;
+            target = 80 + (int)(NextRandom() % 120);
+        }
+    }
+    if (quote) AppendCodepoint(buf, 0x300D);
+}
+
+// 依段落切成頁 (每頁不超過 BENCH_PAGE_BYTES；標籤不跨段落，切頁不會切斷標籤)
+typedef struct {
+    const char* name;
+    TextBuffer text;
+    char** pages;
+    int pageCount;
+} Corpus;
+
+static void SplitPages(Corpus* corpus)
+{
+    const char* text = corpus->text.data;
+    int capacity = 0;
+    int start = 0;
+    while (text[start]) {
+        int end = start, cut = -1;
+        while (text[end] && end - start < BENCH_PAGE_BYTES) {
+            if (text[end] == '\n') cut = end + 1;
+            end++;
+        }
+        if (!text[end]) cut = end;
+        if (cut <= start) cut = end; // 單一段落超過一頁：直接切 (只有 ASCII 與小說語料會發生，不含標籤)
+        while (cut > start && (text[cut] & 0xC0) == 0x80) cut--; // 不切斷 UTF-8
+
+        if (!ReserveArray((void**)&corpus->pages, &capacity, corpus->pageCount + 1, sizeof(char*))) return;
+        char* page = (char*)calloc(cut - start + 1, 1);
+        memcpy(page, text + start, cut - start);
+        corpus->pages[corpus->pageCount++] = page;
+        start = cut;
+    }
+}
+
+static void FreeCorpus(Corpus* corpus)
+{
+    for (int i = 0; i < corpus->pageCount; i++) free(corpus->pages[i]);
+    BenchFree(corpus->pages);
+    BenchFree(corpus->text.data);
+}
+
+// -------------------------------------------------------------------------
+// 量測與輸出
+// -------------------------------------------------------------------------
+
+typedef struct {
+    double start, elapsed;
+    long long allocCount, allocBytes;
+    long long residentBytes;        // 量測期間 RSS 的增量 (無法取得時為 -1)
+    AdvTextCounters counters;       // 預設上下文的累計統計
+    AdvTextStats atlas;             // 量測結束時的圖集頁數、填充率與碎片率
+} BenchMark;
+
+static BenchMark BeginMark(void)
+{
+    return (BenchMark){ .start = NowSeconds(), .allocCount = g_allocCount, .allocBytes = g_allocBytes,
+                        .residentBytes = ResidentBytes(), .counters = GetAdvTextStats().total };
+}
+
+// 結束量測：記錄經過時間，計數改為量測期間的增量
+static void EndMark(BenchMark* mark)
+{
+    mark->atlas = GetAdvTextStats();
+    AdvTextCounters now = mark->atlas.total;
+    mark->elapsed = NowSeconds() - mark->start;
+    mark->allocCount = g_allocCount - mark->allocCount;
+    mark->allocBytes = g_allocBytes - mark->allocBytes;
+    long long resident = ResidentBytes();
+    mark->residentBytes = (resident >= 0 && mark->residentBytes >= 0) ? resident - mark->residentBytes : -1;
+    mark->counters.cacheHits = now.cacheHits - mark->counters.cacheHits;
+    mark->counters.cacheMisses = now.cacheMisses - mark->counters.cacheMisses;
+    mark->counters.flushes = now.flushes - mark->counters.flushes;
+    mark->counters.evictions = now.evictions - mark->counters.evictions;
+    mark->counters.uploadBytes = now.uploadBytes - mark->counters.uploadBytes;
+}
+
+// 一行結果：測試名稱, 語料, 字數, 幀數, ns/字, 每幀配置次數, 每幀配置位元組, Flush 次數, 上傳位元組, 命中率 (-1 為沒有查詢), RSS 增量,
+// 圖集頁數, 填充率, 碎片率 (量測結束時)
+static void ReportMark(const char* bench, const char* corpus, const BenchMark* mark, long long glyphs, int frames)
+{
+    if (frames < 1) frames = 1;
+    unsigned int lookups = mark->counters.cacheHits + mark->counters.cacheMisses;
+    printf("%s,%s,%lld,%d,%.2f,%.2f,%.1f,%u,%llu,%.4f,%lld,%d,%.4f,%.4f\n", bench, corpus, glyphs, frames,
+           glyphs > 0 ? mark->elapsed * 1e9 / glyphs : 0.0,
+           (double)mark->allocCount / frames, (double)mark->allocBytes / frames,
+           mark->counters.flushes, mark->counters.uploadBytes,
+           lookups > 0 ? (double)mark->counters.cacheHits / lookups : -1.0, mark->residentBytes,
+           mark->atlas.atlasPages, mark->atlas.atlasOccupancy, mark->atlas.atlasFragmentation);
+    fflush(stdout);
+}
+
+static int CountGlyphs(const char* text)
+{
+    int count = 0, run = 0, idx = 0, cp = 0;
+    unsigned int key = 0;
+    TokenizeRichText(&g_ctx.runs, text, WHITE);
+    while (NextTextGlyph(&g_ctx.runs, text, &run, &idx, &cp, &key, g_ctx.fontSize, GLYPH_VARIANT_BITMAP)) {
+        if (cp != '\n') count++;
+    }
+    return count;
+}
+
+// 啟動：載入字型並畫出第一頁 (字型載入方式的成本；以 -DADVTEXT_NO_MMAP 編譯可與整檔讀入比較)
+static void BenchStartup(const char* fontPath, const Corpus* corpus)
+{
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f };
+    BenchMark mark = BeginMark();
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    BeginAdvTextFrame();
+    DrawRichTextStyled(corpus->pages[0], (Vector2){ 0, 0 }, -1, style);
+    EndMark(&mark);
+    ReportMark("startup", corpus->name, &mark, CountGlyphs(corpus->pages[0]), 1);
+    UnloadAdvText();
+}
+
+// GetGlyph：冷快取一趟 (含點陣化) 與熱快取重複查詢
+static void BenchGlyphCache(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+
+    // 先取出整份語料的字形鍵，量測時只剩 GetGlyph 本身
+    unsigned int* keys = NULL;
+    int keyCount = 0, keyCapacity = 0;
+    int run = 0, idx = 0, cp = 0;
+    unsigned int key = 0;
+    TokenizeRichText(&g_ctx.runs, corpus->text.data, WHITE);
+    while (NextTextGlyph(&g_ctx.runs, corpus->text.data, &run, &idx, &cp, &key, g_ctx.fontSize, GLYPH_VARIANT_BITMAP)) {
+        if (cp == '\n') continue;
+        if (!ReserveArray((void**)&keys, &keyCapacity, keyCount + 1, sizeof(unsigned int))) break;
+        keys[keyCount++] = key;
+    }
+
+    BenchMark mark = BeginMark();
+    BeginAdvTextFrame();
+    for (int i = 0; i < keyCount; i++) GetGlyph(keys[i]);
+    UploadAtlasPages();
+    EndMark(&mark);
+    ReportMark("glyph_cold", corpus->name, &mark, keyCount, 1);
+
+    mark = BeginMark();
+    for (int pass = 0; pass < BENCH_WARM_PASSES; pass++) {
+        BeginAdvTextFrame();
+        for (int i = 0; i < keyCount; i++) GetGlyph(keys[i]);
+        UploadAtlasPages();
+    }
+    EndMark(&mark);
+    ReportMark("glyph_warm", corpus->name, &mark, (long long)keyCount * BENCH_WARM_PASSES, BENCH_WARM_PASSES);
+
+    // 整頁重新上傳 (Alpha -> RGBA 展開)；glyphs 欄為上傳的像素數
+    mark = BeginMark();
+    for (int pass = 0; pass < BENCH_WARM_PASSES; pass++) {
+        for (int p = 0; p < g_ctx.pageCount; p++) MarkAtlasDirty(&g_ctx.pages[p], 0, 0, ATLAS_SIZE, ATLAS_SIZE);
+        UploadAtlasPages();
+    }
+    EndMark(&mark);
+    ReportMark("atlas_upload", corpus->name, &mark, (long long)g_ctx.pageCount * ATLAS_SIZE * ATLAS_SIZE * BENCH_WARM_PASSES, BENCH_WARM_PASSES);
+
+    BenchFree(keys);
+    UnloadAdvText();
+}
+
+// 圖集打包：同一幀內取得語料中每個字在內文與標題兩種字號的字形 (全部被釘住，放不下就會 Flush 或略過)
+// hanzi3500 為 7000 個字形；不超過 MAX_GLYPHS 時必須全部留在快取中，沒有 Flush 也沒有回收
+static void BenchAtlasPacking(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    const int sizes[] = { BENCH_FONT_SIZE, BENCH_TITLE_SIZE };
+
+    int distinct = 0;
+    BenchMark mark = BeginMark();
+    BeginAdvTextFrame();
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int run = 0, idx = 0, cp = 0;
+        unsigned int key = 0;
+        TokenizeRichText(&g_ctx.runs, corpus->text.data, WHITE);
+        while (NextTextGlyph(&g_ctx.runs, corpus->text.data, &run, &idx, &cp, &key, sizes[s], GLYPH_VARIANT_BITMAP)) {
+            if (cp == '\n' || GlyphIndexFind(key) != -1) continue;
+            distinct++;
+            GetGlyph(key);
+        }
+    }
+    UploadAtlasPages();
+    EndMark(&mark);
+    ReportMark("atlas_pack", corpus->name, &mark, distinct, 1);
+
+    if (distinct <= MAX_GLYPHS) {
+        BenchCheck(mark.counters.flushes == 0 && mark.counters.evictions == 0, "atlas_pack", corpus->name, "working set flushed or evicted");
+        BenchCheck(mark.atlas.glyphCount >= distinct, "atlas_pack", corpus->name, "glyphs missing from the cache");
+    }
+    UnloadAdvText();
+}
+
+// 距離場字形是否合理：四周 SDF_PADDING 的外框都在字形外 (小於 SDF_ONEDGE)，內部至少有一個像素在字形內
+static bool CheckSDFCell(const AdvGlyph* g)
+{
+    const Rectangle* r = &g->srcRec;
+    int x0 = (int)r->x, y0 = (int)r->y, w = (int)r->width, h = (int)r->height;
+    if (w <= 2 * SDF_PADDING || h <= 2 * SDF_PADDING) return false;
+    const unsigned char* pixels = g_ctx.pages[g->page].pixels;
+    int inside = 0;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            unsigned char v = pixels[(size_t)(y0 + y) * ATLAS_SIZE + x0 + x];
+            bool border = (x == 0 || y == 0 || x == w - 1 || y == h - 1);
+            if (border && v >= SDF_ONEDGE) return false;
+            if (v >= SDF_ONEDGE) inside++;
+        }
+    }
+    return inside > 0;
+}
+
+// SDF：第一頁每個字產生距離場 (冷快取)，檢查圖集中的距離值；
+// 再以描邊加陰影的樣式建立繪製清單，SDF 模式每個字只有一個四邊形 (點陣模式為陰影、描邊、本體三個)
+static void BenchSDF(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    const char* text = corpus->pages[0];
+
+    unsigned int* keys = NULL;
+    int keyCount = 0, keyCapacity = 0;
+    int run = 0, idx = 0, cp = 0;
+    unsigned int key = 0;
+    TokenizeRichText(&g_ctx.runs, text, WHITE);
+    while (NextTextGlyph(&g_ctx.runs, text, &run, &idx, &cp, &key, SDF_BASE_SIZE, GLYPH_VARIANT_SDF)) {
+        if (cp == '\n') continue;
+        if (!ReserveArray((void**)&keys, &keyCapacity, keyCount + 1, sizeof(unsigned int))) break;
+        keys[keyCount++] = key;
+    }
+
+    BenchMark mark = BeginMark();
+    BeginAdvTextFrame();
+    for (int i = 0; i < keyCount; i++) GetGlyph(keys[i]);
+    UploadAtlasPages();
+    EndMark(&mark);
+    ReportMark("sdf_raster", corpus->name, &mark, keyCount, 1);
+
+    int bad = 0;
+    for (int i = 0; i < keyCount; i++) {
+        int slot = GlyphIndexFind(keys[i]);
+        const AdvGlyph* g = (slot >= 0) ? &g_ctx.cache[slot] : NULL;
+        if (!g || !g->ready) { bad++; continue; }
+        if (g->srcRec.width > 0 && !CheckSDFCell(g)) bad++;
+    }
+    BenchCheck(bad == 0, "sdf_raster", corpus->name, "SDF cell missing, or distance values not inside-positive with an outside border");
+
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f, .enableSDF = true, .enableOutline = true, .outlineThickness = 2.0f,
+                           .outlineColor = BLACK, .enableShadow = true, .shadowColor = BLACK, .shadowOffset = { 2.0f, 2.0f } };
+    AdvTextLayout* layout = BuildAdvTextLayout(text, style);
+    AdvTextDrawList list = { 0 };
+    BuildAdvTextDrawList(&list, layout, (Vector2){ 0, 0 }, -1);
+    int visible = 0;
+    for (int i = 0; layout && i < layout->glyphCount; i++) {
+        if (layout->glyphs[i].srcRec.width > 0 && layout->glyphs[i].srcRec.height > 0) visible++;
+    }
+    BenchCheck(layout && list.count == visible, "sdf_raster", corpus->name, "outlined SDF text is not one quad per glyph");
+    FreeAdvTextDrawList(&list);
+    FreeAdvTextLayout(layout);
+
+    BenchFree(keys);
+    UnloadAdvText();
+}
+
+// 舊版的字形索引 (模數雜湊 + 線性探測，新增時線性掃描空插槽)，只用來與兩層索引比較
+static struct {
+    int hashLookup[MAX_GLYPHS];
+    int codepoint[MAX_GLYPHS];
+    bool active[MAX_GLYPHS];
+} g_legacy;
+
+static int LegacyIndexFind(int cp)
+{
+    int hashIndex = cp % MAX_GLYPHS;
+    for (int step = 0; step < MAX_GLYPHS; step++) {
+        int cacheIdx = g_legacy.hashLookup[hashIndex];
+        if (cacheIdx == -1) break;
+        if (g_legacy.active[cacheIdx] && g_legacy.codepoint[cacheIdx] == cp) return cacheIdx;
+        hashIndex = (hashIndex + 1) % MAX_GLYPHS;
+    }
+    return -1;
+}
+
+// 新增並回傳插槽與雜湊位置 (沒有空插槽回傳 -1)
+static int LegacyIndexInsert(int cp, int* outHash)
+{
+    int newIdx = -1;
+    for (int i = 0; i < MAX_GLYPHS; i++) {
+        if (!g_legacy.active[i]) { newIdx = i; break; }
+    }
+    if (newIdx == -1) return -1;
+
+    g_legacy.codepoint[newIdx] = cp;
+    g_legacy.active[newIdx] = true;
+    int hashIndex = cp % MAX_GLYPHS;
+    while (g_legacy.hashLookup[hashIndex] != -1) hashIndex = (hashIndex + 1) % MAX_GLYPHS;
+    g_legacy.hashLookup[hashIndex] = newIdx;
+    *outHash = hashIndex;
+    return newIdx;
+}
+
+// 字形索引的命中與未命中延遲：快取填到 MAX_GLYPHS 的 25/50/90%，比較兩層索引與舊版模數雜湊
+// 命中為查詢已在快取中的字；未命中為查詢不在快取中的字並配置插槽、加入索引 (量完還原，佔用率不變)
+// 兩者都不含點陣化，只量索引與插槽配置本身
+static void BenchGlyphIndex(const char* fontPath)
+{
+    static const int occupancy[] = { 25, 50, 90 };
+    for (int o = 0; o < (int)(sizeof(occupancy) / sizeof(occupancy[0])); o++) {
+        int n = MAX_GLYPHS * occupancy[o] / 100;
+        char corpus[16];
+        snprintf(corpus, sizeof(corpus), "occ%d", occupancy[o]);
+
+        InitAdvText(fontPath, BENCH_FONT_SIZE);
+        BeginAdvTextFrame();
+        int strike = GetStrike(ResolveGlyphFont(0, BENCH_INDEX_BASE), g_ctx.fontSize);
+        for (int i = 0; i < n; i++) GetGlyph(MAKE_GLYPH_KEY(strike, BENCH_INDEX_BASE + i, GLYPH_VARIANT_BITMAP));
+        BenchCheck(MAX_GLYPHS - g_ctx.freeSlotCount == n, "index_hit", corpus, "cache did not reach the requested occupancy");
+
+        int found = 0;
+        BenchMark mark = BeginMark();
+        for (int pass = 0; pass < BENCH_WARM_PASSES; pass++) {
+            for (int i = 0; i < n; i++) found += (GlyphIndexFind(MAKE_GLYPH_KEY(strike, BENCH_INDEX_BASE + i, GLYPH_VARIANT_BITMAP)) != -1);
+        }
+        EndMark(&mark);
+        ReportMark("index_hit", corpus, &mark, (long long)n * BENCH_WARM_PASSES, BENCH_WARM_PASSES);
+        BenchCheck(found == n * BENCH_WARM_PASSES, "index_hit", corpus, "cached glyph not found in the index");
+
+        int missed = 0;
+        mark = BeginMark();
+        for (int pass = 0; pass < BENCH_WARM_PASSES; pass++) {
+            for (int i = 0; i < n; i++) {
+                unsigned int key = MAKE_GLYPH_KEY(strike, BENCH_INDEX_BASE + MAX_GLYPHS + i, GLYPH_VARIANT_BITMAP);
+                if (GlyphIndexFind(key) != -1 || g_ctx.freeSlotCount == 0) continue;
+                int slot = g_ctx.freeSlots[--g_ctx.freeSlotCount];
+                missed += GlyphIndexInsert(key, slot);
+                GlyphIndexRemove(key);
+                g_ctx.freeSlots[g_ctx.freeSlotCount++] = slot;
+            }
+        }
+        EndMark(&mark);
+        ReportMark("index_miss", corpus, &mark, (long long)n * BENCH_WARM_PASSES, BENCH_WARM_PASSES);
+        BenchCheck(missed == n * BENCH_WARM_PASSES, "index_miss", corpus, "new glyph could not be added to the index");
+        UnloadAdvText();
+
+        // 舊版：同樣的碼點填入相同的數量
+        memset(g_legacy.hashLookup, 0xFF, sizeof(g_legacy.hashLookup));
+        memset(g_legacy.active, 0, sizeof(g_legacy.active));
+        int hashIndex = 0;
+        for (int i = 0; i < n; i++) LegacyIndexInsert(BENCH_INDEX_BASE + i, &hashIndex);
+
+        found = 0;
+        mark = BeginMark();
+        for (int pass = 0; pass < BENCH_WARM_PASSES; pass++) {
+            for (int i = 0; i < n; i++) found += (LegacyIndexFind(BENCH_INDEX_BASE + i) != -1);
+        }
+        EndMark(&mark);
+        ReportMark("index_hit_legacy", corpus, &mark, (long long)n * BENCH_WARM_PASSES, BENCH_WARM_PASSES);
+        BenchCheck(found == n * BENCH_WARM_PASSES, "index_hit_legacy", corpus, "cached glyph not found in the legacy index");
+
+        missed = 0;
+        mark = BeginMark();
+        for (int pass = 0; pass < BENCH_WARM_PASSES; pass++) {
+            for (int i = 0; i < n; i++) {
+                int cp = BENCH_INDEX_BASE + MAX_GLYPHS + i;
+                if (LegacyIndexFind(cp) != -1) continue;
+                int slot = LegacyIndexInsert(cp, &hashIndex);
+                if (slot == -1) continue;
+                g_legacy.hashLookup[hashIndex] = -1; // 新項目在探測鏈尾端，清掉不會切斷其他鏈
+                g_legacy.active[slot] = false;
+                missed++;
+            }
+        }
+        EndMark(&mark);
+        ReportMark("index_miss_legacy", corpus, &mark, (long long)n * BENCH_WARM_PASSES, BENCH_WARM_PASSES);
+        BenchCheck(missed == n * BENCH_WARM_PASSES, "index_miss_legacy", corpus, "new glyph could not be added to the legacy index");
+    }
+}
+
+// 標籤解析：TokenizeRichText 加上走訪所有碼點 (NextTextGlyph)；glyphs 欄為位元組數，1000 / ns_per_glyph 即 MB/s
+static void BenchTokenize(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    const char* text = corpus->text.data;
+    CountGlyphs(text); // 先建立字典與 strike，量測時只剩解析本身
+
+    long long visible = 0;
+    BenchMark mark = BeginMark();
+    for (int pass = 0; pass < BENCH_TOKENIZE_PASSES; pass++) {
+        int run = 0, idx = 0, cp = 0;
+        unsigned int key = 0;
+        TokenizeRichText(&g_ctx.runs, text, WHITE);
+        while (NextTextGlyph(&g_ctx.runs, text, &run, &idx, &cp, &key, g_ctx.fontSize, GLYPH_VARIANT_BITMAP)) visible++;
+    }
+    EndMark(&mark);
+    ReportMark("tokenize", corpus->name, &mark, (long long)corpus->text.length * BENCH_TOKENIZE_PASSES, BENCH_TOKENIZE_PASSES);
+    BenchCheck(visible > 0, "tokenize", corpus->name, "no codepoints returned");
+    UnloadAdvText();
+}
+
+// 標籤解析的亂數測試：可辨識與殘缺的標籤、巢狀、換行、多位元組與截斷的 UTF-8 隨機拼接
+// 每個輸入配置剛好的大小 (以 -fsanitize=address 編譯即可抓到越界讀取)，並檢查：
+// 片段依序且在原文範圍內、片段之間只有完整的標籤、NextTextGlyph 逐一回傳片段中的每個碼點 (沒有遺漏或重複)
+static void BenchTokenizeFuzz(const char* fontPath)
+{
+    static const char* pieces[] = {
+        "[color=red]", "[/color]", "[color=#FF8800AA]", "[color=#12]", "[font=bold]", "[/font]", "[pause=0.5]",
+        "[pause=]", "[/pause]", "[color]", "[unknown=1]", "[", "]", "[[", "]]", "=", "/", "#",
+        "a", "Z", " ", "\n", "\xE5\xA4\xA9", "\xF0\x9F\x98\x80", "\xE4", "\x80", "\xF0\x9F", "\xC3\xA9", "\xE3\x80\x8C"
+    };
+    const int pieceCount = (int)(sizeof(pieces) / sizeof(pieces[0]));
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    g_seed = 14;
+
+    long long bytes = 0;
+    int failures = 0;
+    BenchMark mark = BeginMark();
+    for (int n = 0; n < BENCH_FUZZ_INPUTS && failures == 0; n++) {
+        char tmp[BENCH_FUZZ_PIECES * 24];
+        int len = 0, count = 1 + (int)(NextRandom() % BENCH_FUZZ_PIECES);
+        for (int i = 0; i < count; i++) {
+            const char* piece = pieces[NextRandom() % pieceCount];
+            int plen = (int)strlen(piece);
+            memcpy(tmp + len, piece, plen);
+            len += plen;
+        }
+        char* text = (char*)malloc(len + 1); // 剛好的大小：越界讀取落在配置之外
+        memcpy(text, tmp, len);
+        text[len] = '\0';
+        bytes += len;
+
+        const TextRunList* runs = &g_ctx.runs;
+        bool ok = TokenizeRichText(&g_ctx.runs, text, WHITE);
+
+        // 片段依序、在原文範圍內，片段之間 (與前後) 只能是完整的標籤
+        int expected = 0, prevEnd = 0;
+        for (int r = 0; ok && r <= runs->count; r++) {
+            int start = (r < runs->count) ? runs->runs[r].start : len;
+            if (start < prevEnd || start > len) { ok = false; break; }
+            if (start > prevEnd && (text[prevEnd] != '[' || text[start - 1] != ']')) ok = false;
+            if (r == runs->count) break;
+            int end = runs->runs[r].end;
+            if (end < start || end > len) { ok = false; break; }
+            for (int i = start; i < end; ) {
+                int size = 0;
+                GetCodepointNext(&text[i], &size);
+                i += (size > 0) ? size : 1;
+                expected++;
+            }
+            prevEnd = end;
+        }
+
+        // NextTextGlyph 回傳的碼點與片段的內容一一對應，位置只往前進
+        int run = 0, idx = 0, cp = 0, got = 0, last = -1;
+        unsigned int key = 0;
+        while (ok && NextTextGlyph(runs, text, &run, &idx, &cp, &key, g_ctx.fontSize, GLYPH_VARIANT_BITMAP)) {
+            if (idx <= last || idx > len) ok = false;
+            last = idx;
+            got++;
+        }
+        if (!ok || got != expected) {
+            fprintf(stderr, "rtextbench: tokenize_fuzz input %d (%d bytes): %d of %d codepoints\n", n, len, got, expected);
+            failures++;
+        }
+        free(text);
+    }
+    EndMark(&mark);
+    ReportMark("tokenize_fuzz", "fuzz", &mark, bytes, BENCH_FUZZ_INPUTS);
+    BenchCheck(failures == 0, "tokenize_fuzz", "fuzz", "runs out of order, stray text between runs, or lost codepoints");
+    UnloadAdvText();
+}
+
+// DrawRichTextStyled：每幀畫一頁；第一輪為冷快取 (含點陣化與上傳)，其餘各輪合併成一行熱快取結果
+static void BenchLayout(const char* fontPath, const Corpus* corpus, int loops)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f, .enableShadow = true, .shadowColor = BLACK, .shadowOffset = { 2.0f, 2.0f } };
+
+    long long glyphs = 0;
+    for (int p = 0; p < corpus->pageCount; p++) glyphs += CountGlyphs(corpus->pages[p]);
+
+    BenchMark mark = { 0 };
+    for (int loop = 0; loop < loops; loop++) {
+        if (loop <= 1) mark = BeginMark();
+        for (int p = 0; p < corpus->pageCount; p++) {
+            BeginAdvTextFrame();
+            DrawRichTextStyled(corpus->pages[p], (Vector2){ 0, 0 }, -1, style);
+        }
+        if (loop == 0) {
+            EndMark(&mark);
+            ReportMark("layout_cold", corpus->name, &mark, glyphs, corpus->pageCount);
+        }
+    }
+    EndMark(&mark);
+    ReportMark("layout_warm", corpus->name, &mark, glyphs * (loops - 1), corpus->pageCount * (loops - 1));
+
+    // UI 常見的先量測再繪製：量測的排版留在備忘中，繪製直接沿用 (成本應與 layout_warm 相近，而不是兩倍)
+    mark = BeginMark();
+    for (int loop = 1; loop < loops; loop++) {
+        for (int p = 0; p < corpus->pageCount; p++) {
+            BeginAdvTextFrame();
+            AdvTextMetrics metrics = MeasureRichText(corpus->pages[p], style);
+            DrawRichTextStyled(corpus->pages[p], (Vector2){ -metrics.bounds.x, 0 }, -1, style);
+        }
+    }
+    EndMark(&mark);
+    ReportMark("measure_draw", corpus->name, &mark, glyphs * (loops - 1), corpus->pageCount * (loops - 1));
+
+    // 同樣的頁改用區塊快取：每頁停留 BENCH_CACHED_FRAMES 幀 (第一幀畫進紋理，之後只畫一個四邊形)
+    mark = BeginMark();
+    for (int p = 0; p < corpus->pageCount; p++) {
+        for (int f = 0; f < BENCH_CACHED_FRAMES; f++) {
+            BeginAdvTextFrame();
+            DrawRichTextCached(corpus->pages[p], (Vector2){ 0, 0 }, style);
+        }
+    }
+    EndMark(&mark);
+    ReportMark("layout_cached", corpus->name, &mark, glyphs * BENCH_CACHED_FRAMES, corpus->pageCount * BENCH_CACHED_FRAMES);
+
+    UnloadAdvText();
+}
+
+// 繪製清單是否與排版一致：依圖層 (陰影 -> 描邊 -> 本體)、每層依圖集頁、頁內依字序逐一比對
+// 每個四邊形的 UV 必須在 0~1 內且等於字形快取插槽的 srcRec / ATLAS_SIZE，dest 的大小等於字形大小
+static bool CheckDrawList(const AdvTextDrawList* list, const AdvTextLayout* layout, Vector2 pos)
+{
+    const AdvTextStyle* style = &layout->style;
+    float r = (float)layout->outlineRadius;
+    int q = 0;
+
+    for (int layer = 0; layer < 3; layer++) {
+        if (layer == 0 && (!style->enableShadow || style->enableSDF)) continue;
+        if (layer == 1 && layout->outlineRadius <= 0) continue;
+
+        for (int p = 0; p < g_ctx.pageCount; p++) {
+            for (int i = 0; i < layout->glyphCount; i++) {
+                const AdvLayoutGlyph* lg = &layout->glyphs[i];
+                int page = (layer == 1) ? lg->outlinePage : lg->page;
+                int slot = (layer == 1) ? lg->outlineSlot : lg->slot;
+                Rectangle src = (layer == 1) ? lg->outlineRec : lg->srcRec;
+                if (page != p || src.width <= 0 || src.height <= 0) continue;
+                if (q >= list->count || slot < 0) return false;
+
+                const AdvTextQuad* quad = &list->quads[q++];
+                const AdvGlyph* g = &g_ctx.cache[slot];
+                if (quad->page != p || !g->ready || g->page != p) return false;
+                if (g->srcRec.x != src.x || g->srcRec.y != src.y || g->srcRec.width != src.width || g->srcRec.height != src.height) return false;
+                if (quad->uv.x < 0.0f || quad->uv.y < 0.0f || quad->uv.x + quad->uv.width > 1.0f || quad->uv.y + quad->uv.height > 1.0f) return false;
+                if (quad->uv.x != src.x / ATLAS_SIZE || quad->uv.y != src.y / ATLAS_SIZE ||
+                    quad->uv.width != src.width / ATLAS_SIZE || quad->uv.height != src.height / ATLAS_SIZE) return false;
+
+                Vector2 at = { pos.x + lg->offset.x, pos.y + lg->offset.y };
+                if (layer == 0) at = (Vector2){ at.x + style->shadowOffset.x, at.y + style->shadowOffset.y };
+                if (layer == 1) at = (Vector2){ at.x - r, at.y - r };
+                float scale = (layer == 2) ? layout->glyphScale : 1.0f;
+                if (quad->dest.x != at.x || quad->dest.y != at.y ||
+                    quad->dest.width != src.width * scale || quad->dest.height != src.height * scale) return false;
+            }
+        }
+    }
+    return q == list->count;
+}
+
+// 無視窗繪製清單：每頁建立一次描邊加陰影的排版，之後每幀只 BuildAdvTextDrawList (不提交)
+// 最後一輪逐一檢查四邊形數、圖層順序、UV 與大小
+static void BenchDrawList(const char* fontPath, const Corpus* corpus, int loops)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f, .enableShadow = true, .shadowColor = BLACK, .shadowOffset = { 2.0f, 2.0f },
+                           .enableOutline = true, .outlineColor = BLACK, .outlineThickness = 2.0f };
+
+    AdvTextLayout** layouts = BenchAlloc(corpus->pageCount * sizeof(AdvTextLayout*));
+    long long glyphs = 0;
+    for (int p = 0; p < corpus->pageCount; p++) {
+        BeginAdvTextFrame();
+        layouts[p] = BuildAdvTextLayout(corpus->pages[p], style);
+        glyphs += CountGlyphs(corpus->pages[p]);
+    }
+
+    AdvTextDrawList list = { 0 };
+    int bad = 0;
+    BenchMark mark = BeginMark();
+    for (int loop = 0; loop < loops; loop++) {
+        for (int p = 0; p < corpus->pageCount; p++) {
+            BeginAdvTextFrame();
+            BuildAdvTextDrawList(&list, layouts[p], (Vector2){ 8.0f, 8.0f }, -1);
+            if (loop == loops - 1 && (!layouts[p] || !CheckDrawList(&list, layouts[p], (Vector2){ 8.0f, 8.0f }))) bad++;
+        }
+    }
+    EndMark(&mark);
+    ReportMark("draw_list", corpus->name, &mark, glyphs * loops, corpus->pageCount * loops);
+    BenchCheck(bad == 0, "draw_list", corpus->name, "draw-list quads do not match the layout (count, layer order, UV or size)");
+
+    FreeAdvTextDrawList(&list);
+    for (int p = 0; p < corpus->pageCount; p++) FreeAdvTextLayout(layouts[p]);
+    BenchFree(layouts);
+    UnloadAdvText();
+}
+
+// 重新換行的結果是否與以同樣寬度重新建立的排版完全一致 (行數、每行字數與寬度、每個字形的位置)
+static bool CheckReflow(const AdvTextLayout* reflowed, const AdvTextLayout* fresh)
+{
+    if (!reflowed || !fresh) return false;
+    if (reflowed->glyphCount != fresh->glyphCount || reflowed->lineCount != fresh->lineCount) return false;
+    if (reflowed->width != fresh->width || reflowed->height != fresh->height) return false;
+
+    for (int l = 0; l < fresh->lineCount; l++) {
+        const AdvLayoutLine* a = &reflowed->lines[l];
+        const AdvLayoutLine* b = &fresh->lines[l];
+        if (a->firstGlyph != b->firstGlyph || a->glyphCount != b->glyphCount || a->width != b->width || a->y != b->y) return false;
+    }
+    for (int i = 0; i < fresh->glyphCount; i++) {
+        const AdvLayoutGlyph* a = &reflowed->glyphs[i];
+        const AdvLayoutGlyph* b = &fresh->glyphs[i];
+        if (a->key != b->key || a->offset.x != b->offset.x || a->offset.y != b->offset.y) return false;
+    }
+    return true;
+}
+
+// 字距的每字成本：字形快取與字距表都熱身後，每頁重複 BuildAdvTextLayout (不繪製)
+// kern_memo 為預設路徑 (相鄰字對查字距表)，kern_off 略過字距查詢，兩者 ns_per_glyph 的差即字距的額外成本
+static void BenchKerning(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f };
+    bool hasKerning = g_ctx.fonts[0].hasKerning;
+    if (!hasKerning) fprintf(stderr, "rtextbench: %s has no kern/GPOS table, kern_memo and kern_off measure the same path\n", fontPath);
+
+    long long glyphs = 0;
+    for (int p = 0; p < corpus->pageCount; p++) {
+        BeginAdvTextFrame();
+        FreeAdvTextLayout(BuildAdvTextLayout(corpus->pages[p], style));
+        glyphs += CountGlyphs(corpus->pages[p]);
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        g_ctx.fonts[0].hasKerning = hasKerning && (pass == 0);
+        BenchMark mark = BeginMark();
+        for (int p = 0; p < corpus->pageCount; p++) {
+            for (int n = 0; n < BENCH_KERN_PASSES; n++) FreeAdvTextLayout(BuildAdvTextLayout(corpus->pages[p], style));
+        }
+        EndMark(&mark);
+        ReportMark((pass == 0) ? "kern_memo" : "kern_off", corpus->name, &mark, glyphs * BENCH_KERN_PASSES, corpus->pageCount * BENCH_KERN_PASSES);
+    }
+    g_ctx.fonts[0].hasKerning = hasKerning;
+
+    UnloadAdvText();
+}
+
+// 寬度動畫：每幀以新的寬度重新建立排版 (reflow_rebuild)，與建立一次後只重新換行 (reflow) 比較
+// 最後的寬度下把重新換行的結果與重新建立的排版逐一比對
+static void BenchReflow(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f };
+
+    // 先畫一輪，量測時字形都在快取中
+    long long glyphs = 0;
+    for (int p = 0; p < corpus->pageCount; p++) {
+        BeginAdvTextFrame();
+        DrawRichTextStyled(corpus->pages[p], (Vector2){ 0, 0 }, -1, style);
+        glyphs += CountGlyphs(corpus->pages[p]);
+    }
+
+    BenchMark mark = BeginMark();
+    for (int p = 0; p < corpus->pageCount; p++) {
+        for (int f = 0; f < BENCH_REFLOW_FRAMES; f++) {
+            style.maxWidth = 320.0f + 320.0f * (float)abs(f - BENCH_REFLOW_FRAMES / 2) / (BENCH_REFLOW_FRAMES / 2);
+            AdvTextLayout* layout = BuildAdvTextLayout(corpus->pages[p], style);
+            FreeAdvTextLayout(layout);
+        }
+    }
+    EndMark(&mark);
+    ReportMark("reflow_rebuild", corpus->name, &mark, glyphs * BENCH_REFLOW_FRAMES, corpus->pageCount * BENCH_REFLOW_FRAMES);
+
+    // 量測迴圈結束時 style.maxWidth 即為最後一幀的寬度
+    AdvTextLayout** layouts = BenchAlloc(corpus->pageCount * sizeof(AdvTextLayout*));
+    mark = BeginMark();
+    for (int p = 0; p < corpus->pageCount; p++) {
+        AdvTextLayout* layout = BuildAdvTextLayout(corpus->pages[p], style);
+        for (int f = 0; f < BENCH_REFLOW_FRAMES; f++) {
+            ReflowAdvTextLayout(layout, 320.0f + 320.0f * (float)abs(f - BENCH_REFLOW_FRAMES / 2) / (BENCH_REFLOW_FRAMES / 2));
+        }
+        layouts[p] = layout;
+    }
+    EndMark(&mark);
+    ReportMark("reflow", corpus->name, &mark, glyphs * BENCH_REFLOW_FRAMES, corpus->pageCount * BENCH_REFLOW_FRAMES);
+
+    int bad = 0;
+    for (int p = 0; p < corpus->pageCount; p++) {
+        AdvTextLayout* fresh = BuildAdvTextLayout(corpus->pages[p], style);
+        if (!CheckReflow(layouts[p], fresh)) bad++;
+        FreeAdvTextLayout(fresh);
+        FreeAdvTextLayout(layouts[p]);
+    }
+    BenchFree(layouts);
+    BenchCheck(bad == 0, "reflow", corpus->name, "reflowed layout differs from a fresh build at the same width (lines, line widths or glyph offsets)");
+
+    UnloadAdvText();
+}
+
+// 打字機：每頁以固定幀時間推進到顯示完畢 (舊版 UpdateTypewriter 每幀重新掃描整頁；AdvTypewriter 含建立)
+static void BenchTypewriter(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f };
+
+    // 先畫一輪，量測時字形都在快取中
+    long long glyphs = 0;
+    for (int p = 0; p < corpus->pageCount; p++) {
+        BeginAdvTextFrame();
+        DrawRichTextStyled(corpus->pages[p], (Vector2){ 0, 0 }, -1, style);
+        glyphs += CountGlyphs(corpus->pages[p]);
+    }
+
+    int frames = 0;
+    BenchMark mark = BeginMark();
+    for (int p = 0; p < corpus->pageCount; p++) {
+        Typewriter tw = { .speed = BENCH_TYPEWRITER_SPEED };
+        while (!tw.isFinished) {
+            BeginAdvTextFrame();
+            UpdateTypewriter(&tw, corpus->pages[p], BENCH_FRAME_TIME);
+            frames++;
+        }
+    }
+    EndMark(&mark);
+    ReportMark("typewriter_legacy", corpus->name, &mark, glyphs, frames);
+
+    frames = 0;
+    mark = BeginMark();
+    for (int p = 0; p < corpus->pageCount; p++) {
+        AdvTypewriter* tw = CreateAdvTypewriter(corpus->pages[p], style, (AdvTypewriterConfig){ .speed = BENCH_TYPEWRITER_SPEED });
+        while (tw && !IsAdvTypewriterFinished(tw)) {
+            BeginAdvTextFrame();
+            UpdateAdvTypewriter(tw, BENCH_FRAME_TIME);
+            frames++;
+        }
+        FreeAdvTypewriter(tw);
+    }
+    EndMark(&mark);
+    ReportMark("typewriter_adv", corpus->name, &mark, glyphs, frames);
+
+    UnloadAdvText();
+}
+
+// 長文件：整份語料建立一份 AdvTextDocument，再以固定速度捲到底 (每幀成本應與文件長度無關)
+static void BenchDocument(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f };
+    Rectangle clip = { 0.0f, 0.0f, 640.0f, 480.0f };
+    long long glyphs = CountGlyphs(corpus->text.data);
+
+    BenchMark mark = BeginMark();
+    BeginAdvTextFrame();
+    AdvTextDocument* doc = BuildAdvTextDocument(corpus->text.data, style);
+    EndMark(&mark);
+    ReportMark("document_build", corpus->name, &mark, glyphs, 1);
+
+    // 字數以每幀實際排版的可見範圍計
+    long long drawn = 0;
+    int frames = 0;
+    float height = GetAdvTextDocumentSize(doc).y;
+    mark = BeginMark();
+    for (float y = 0.0f; doc && y < height; y += BENCH_SCROLL_STEP) {
+        BeginAdvTextFrame();
+        DrawAdvTextDocument(doc, (Vector2){ 0.0f, -y }, clip);
+        drawn += doc->window.glyphCount;
+        frames++;
+    }
+    EndMark(&mark);
+    ReportMark("document_scroll", corpus->name, &mark, drawn, frames);
+
+    FreeAdvTextDocument(doc);
+    UnloadAdvText();
+}
+
+// 串流文字：每頁當成一則訊息追加到串流並畫一幀；追加多輪，成本應與累積的紀錄長度無關
+static void BenchStream(const char* fontPath, const Corpus* corpus)
+{
+    InitAdvText(fontPath, BENCH_FONT_SIZE);
+    AdvTextStyle style = { .baseColor = RAYWHITE, .maxWidth = 640.0f };
+    Rectangle bounds = { 0.0f, 0.0f, 640.0f, 480.0f };
+    AdvTextStream* stream = CreateAdvTextStream(style, BENCH_STREAM_LINES, 0);
+
+    long long glyphs = 0;
+    for (int p = 0; p < corpus->pageCount; p++) glyphs += CountGlyphs(corpus->pages[p]);
+
+    BenchMark mark = BeginMark();
+    for (int pass = 0; stream && pass < BENCH_STREAM_PASSES; pass++) {
+        for (int p = 0; p < corpus->pageCount; p++) {
+            BeginAdvTextFrame();
+            AppendAdvText(stream, corpus->pages[p]);
+            DrawAdvTextStream(stream, bounds, 0.0f);
+        }
+    }
+    EndMark(&mark);
+    ReportMark("stream_append", corpus->name, &mark, glyphs * BENCH_STREAM_PASSES, corpus->pageCount * BENCH_STREAM_PASSES);
+
+    FreeAdvTextStream(stream);
+    UnloadAdvText();
+}
+
+int main(int argc, char** argv)
+{
+    const char* fontPath = (argc > 1) ? argv[1] : "assets/tpu.ttf";
+    int loops = (argc > 2) ? atoi(argv[2]) : 3;
+    if (loops < 2) loops = 2;
+
+    SetTraceLogCallback(BenchTraceLog);
+    if (!FileExists(fontPath)) {
+        fprintf(stderr, "rtextbench: font %s not found\n", fontPath);
+        return 1;
+    }
+
+    BuildHanziSet();
+    Corpus corpora[] = { { .name = "ascii" }, { .name = "tags" }, { .name = "hanzi3500" }, { .name = "novel" } };
+    BuildAsciiCorpus(&corpora[0].text);
+    BuildTagCorpus(&corpora[1].text);
+    BuildHanziCorpus(&corpora[2].text);
+    BuildNovelCorpus(&corpora[3].text);
+
+    printf("bench,corpus,glyphs,frames,ns_per_glyph,allocs_per_frame,alloc_bytes_per_frame,flushes,upload_bytes,hit_rate,rss_delta_bytes,"
+           "atlas_pages,atlas_occupancy,atlas_fragmentation\n");
+    for (int c = 0; c < (int)(sizeof(corpora) / sizeof(corpora[0])); c++) {
+        SplitPages(&corpora[c]);
+        BenchStartup(fontPath, &corpora[c]);
+        BenchGlyphCache(fontPath, &corpora[c]);
+        BenchAtlasPacking(fontPath, &corpora[c]);
+        BenchTokenize(fontPath, &corpora[c]);
+        BenchSDF(fontPath, &corpora[c]);
+        BenchLayout(fontPath, &corpora[c], loops);
+        BenchDrawList(fontPath, &corpora[c], loops);
+        BenchKerning(fontPath, &corpora[c]);
+        BenchReflow(fontPath, &corpora[c]);
+        BenchTypewriter(fontPath, &corpora[c]);
+        BenchDocument(fontPath, &corpora[c]);
+        BenchStream(fontPath, &corpora[c]);
+        FreeCorpus(&corpora[c]);
+    }
+    BenchTokenizeFuzz(fontPath);
+    BenchGlyphIndex(fontPath);
+    return (g_checkFailures > 0) ? 2 : 0;
+}
@@ -21,11 +21,9 @@ int main(void)
         "當字形數量超過 4096 時，系統會自動執行 Flush 清空圖集，\n"
         "確保程式不會崩潰，且畫面保持流暢！";
 
-    Typewriter tw = {
+    AdvTypewriterConfig twConfig = {
         .speed = 20.0f,
-        .elapsed = 0.0f,
-        .currentChars = 0,
-        .isFinished = false
+        .punctuationDelay = 0.0f
     };
 
     AdvTextStyle style = {
@@ -49,15 +47,21 @@ int main(void)
         .outlineThickness = 1.5f
     };
 
+    // 背景執行緒先點陣化對話用到的字形 (就緒前打字機會停在未就緒的字)
+    PrefetchAdvText(storyText);
+
+    // 對話文字不會每幀改變：建立時排版並算好每個字的顯示時間，之後每幀只推進索引
+    AdvTypewriter* tw = CreateAdvTypewriter(storyText, style, twConfig);
+
     while (!WindowShouldClose()) {
+        BeginAdvTextFrame(); // 讓快取知道新的一幀開始 (LRU 回收依據)
         float dt = GetFrameTime();
         // 更新打字機
-        UpdateTypewriter(&tw, storyText, dt);
+        UpdateAdvTypewriter(tw, dt);
         // 重播控制
         if (IsKeyPressed(KEY_SPACE)) {
-            tw.elapsed = 0.0f;
-            tw.currentChars = 0;
-            tw.isFinished = false;
+            FreeAdvTypewriter(tw);
+            tw = CreateAdvTypewriter(storyText, style, twConfig);
         }
         BeginDrawing();
         ClearBackground((Color){ 100, 100, 100, 255 }); // 灰色背景以凸顯半透明對話框
@@ -66,10 +70,11 @@ int main(void)
         DrawRichTextStyled("Press SPACE to Replay", (Vector2){ GetScreenWidth()/2.0f, 10 }, -1, style);
         DrawFPS(10, 40);
         // 繪製富文本
-        DrawRichTextStyled(storyText, (Vector2){ GetScreenWidth()/2.0f, 100 }, tw.currentChars, style);
+        DrawAdvTypewriter(tw, (Vector2){ GetScreenWidth()/2.0f, 100 });
         EndDrawing();
     }
 
+    FreeAdvTypewriter(tw);
     UnloadAdvText();
     CloseWindow();
     return 0;